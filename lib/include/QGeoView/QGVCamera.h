@@ -92,12 +92,15 @@ public:
 
     void setDuration(int msecs);
     int duration() const override;
+    void setPrefetch(bool enabled);
+    bool isPrefetch() const;
     QGVCameraActions& actions();
 
 protected:
     virtual void onStart();
     virtual void onStop();
     virtual void onProgress(double progress, QGVCameraActions& target) = 0;
+    virtual QList<QGVCameraActions> prefetchTargets();
 
     static double interpolateScale(double from, double to, double progress);
     static double interpolateAzimuth(double from, double to, double progress);
@@ -110,6 +113,7 @@ private:
 
 private:
     int mDuration;
+    bool mPrefetch;
     QGVCameraActions mActions;
 };
 
@@ -135,6 +139,7 @@ public:
 private:
     void onStart() override;
     void onProgress(double progress, QGVCameraActions& target) override;
+    QList<QGVCameraActions> prefetchTargets() override;
 
 private:
     double mFlyScale;
@@ -45,6 +45,7 @@ public:
     virtual void projPaint(QPainter* painter) = 0;
     virtual QPointF projAnchor() const;
     virtual QTransform projTransform() const;
+    virtual QGraphicsItem::CacheMode projCacheMode() const;
     virtual QString projTooltip(const QPointF& projPos) const;
     virtual QString projDebug();
     virtual void projOnFlags();
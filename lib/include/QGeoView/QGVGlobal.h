@@ -32,6 +32,8 @@
 #endif
 #endif
 
+class QGVTilesStore;
+
 namespace QGV {
 
 enum class Projection
@@ -66,6 +68,20 @@ enum class MapState
     SelectionRect,
 };
 
+enum class TilesRenderMode
+{
+    Items,
+    Composite,
+};
+
+enum class TilesScheme
+{
+    XYZ,
+    TMS,
+    WMTS,
+    WMS,
+};
+
 enum class DistanceUnits
 {
     Meters,
@@ -178,6 +194,9 @@ public:
     bool contains(const GeoTilePos& other) const;
     GeoTilePos parent(int parentZoom) const;
 
+    quint64 toKey() const;
+    static GeoTilePos fromKey(quint64 key);
+
     GeoRect toGeoRect() const;
     QString toQuadKey() const;
 
@@ -190,6 +209,8 @@ private:
 
 QGV_LIB_DECL void setNetworkManager(QNetworkAccessManager* manager);
 QGV_LIB_DECL QNetworkAccessManager* getNetworkManager();
+QGV_LIB_DECL void setTilesStore(QGVTilesStore* store);
+QGV_LIB_DECL QGVTilesStore* getTilesStore();
 
 QGV_LIB_DECL QTransform createTransfrom(QPointF const& projAnchor, double scale, double azimuth);
 QGV_LIB_DECL QTransform createTransfromScale(QPointF const& projAnchor, double scale);
@@ -70,12 +70,19 @@ public:
     bool effectivelyVisible() const;
 
     void update();
+    void beginUpdate();
+    void endUpdate();
 
     virtual void onProjection(QGVMap* geoMap);
     virtual void onCamera(const QGVCameraState& oldState, const QGVCameraState& newState);
+    virtual void onPrefetch(const QList<QGVCameraState>& targetStates);
     virtual void onUpdate();
     virtual void onClean();
 
+private:
+    void updateEffective() const;
+    void invalidateEffective();
+
 private:
     Q_DISABLE_COPY(QGVItem)
     QGVItem* mParent;
@@ -85,4 +92,12 @@ private:
     bool mSelectable;
     bool mSelected;
     QList<QGVItem*> mChildrens;
+    QList<QPointer<QGVMap>> mUpdateMaps;
+
+    // Effective values are cached, valid item always has valid ancestors
+    mutable bool mEffectiveValid;
+    mutable bool mEffectiveVisible;
+    mutable double mEffectiveZValue;
+    mutable double mEffectiveOpacity;
+    mutable double mChildZRange;
 };
@@ -18,9 +18,9 @@
 
 #pragma once
 
-#include "QGVLayerTilesOnline.h"
+#include "QGVLayerTemplate.h"
 
-class QGV_LIB_DECL QGVLayerBDGEx : public QGVLayerTilesOnline
+class QGV_LIB_DECL QGVLayerBDGEx : public QGVLayerTemplate
 {
     Q_OBJECT
 
@@ -31,11 +31,6 @@ public:
     void setUrl(const QString& url);
     QString getUrl() const;
 
-private:
-    int minZoomlevel() const override;
-    int maxZoomlevel() const override;
-    QString tilePosToUrl(const QGV::GeoTilePos& tilePos) const override;
-
 private:
     QString mUrl;
 };
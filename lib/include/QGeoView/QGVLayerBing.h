@@ -19,6 +19,7 @@
 #pragma once
 
 #include "QGVLayerTilesOnline.h"
+#include "QGVUrlTemplate.h"
 
 class QGV_LIB_DECL QGVLayerBing : public QGVLayerTilesOnline
 {
@@ -40,9 +41,14 @@ private:
     int minZoomlevel() const override;
     int maxZoomlevel() const override;
     QString tilePosToUrl(const QGV::GeoTilePos& tilePos) const override;
+    QStringList tilePosToMirrorUrls(const QGV::GeoTilePos& tilePos) const override;
+    QGVUrlTemplate::Values values(const QGV::GeoTilePos& tilePos) const;
+    void compile();
 
 private:
     QGV::TilesType mType;
     QLocale mLocale;
     int mServerNumber;
+    QString mLocaleName;
+    QVector<QGVUrlTemplate> mTemplates;
 };
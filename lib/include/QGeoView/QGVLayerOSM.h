@@ -19,6 +19,7 @@
 #pragma once
 
 #include "QGVLayerTilesOnline.h"
+#include "QGVUrlTemplate.h"
 
 class QGV_LIB_DECL QGVLayerOSM : public QGVLayerTilesOnline
 {
@@ -31,11 +32,19 @@ public:
     void setUrl(const QString& url);
     QString getUrl() const;
 
+    void setMirrorUrls(const QStringList& urls);
+    QStringList getMirrorUrls() const;
+
 private:
     int minZoomlevel() const override;
     int maxZoomlevel() const override;
     QString tilePosToUrl(const QGV::GeoTilePos& tilePos) const override;
+    QStringList tilePosToMirrorUrls(const QGV::GeoTilePos& tilePos) const override;
+    void compile();
 
 private:
     QString mUrl;
+    QStringList mMirrors;
+    QGVUrlTemplate mTemplate;
+    QVector<QGVUrlTemplate> mMirrorTemplates;
 };
@@ -0,0 +1,73 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVLayerTilesOnline.h"
+#include "QGVUrlTemplate.h"
+
+/*!
+ * Online tiles layer described only by url template and tiles scheme (XYZ, TMS, WMTS or WMS GetMap).
+ * Subdomains ({s}) are used as mirrors of provider.
+ */
+class QGV_LIB_DECL QGVLayerTemplate : public QGVLayerTilesOnline
+{
+    Q_OBJECT
+
+public:
+    explicit QGVLayerTemplate(const QString& urlTemplate = {}, QGV::TilesScheme scheme = QGV::TilesScheme::XYZ);
+
+    void setUrlTemplate(const QString& urlTemplate);
+    QString getUrlTemplate() const;
+
+    void setScheme(QGV::TilesScheme scheme);
+    QGV::TilesScheme getScheme() const;
+
+    void setSubdomains(const QStringList& subdomains);
+    QStringList getSubdomains() const;
+
+    void setZoomRange(int minZoom, int maxZoom);
+    void setTileSize(const QSize& size);
+    QSize getTileSize() const;
+
+    void setTileMatrixSet(const QString& tileMatrixSet, const QStringList& tileMatrices = {});
+    QString getTileMatrixSet() const;
+
+    void setWmsCrs(const QString& crs);
+    QString getWmsCrs() const;
+
+protected:
+    int minZoomlevel() const override;
+    int maxZoomlevel() const override;
+    QString tilePosToUrl(const QGV::GeoTilePos& tilePos) const override;
+    QStringList tilePosToMirrorUrls(const QGV::GeoTilePos& tilePos) const override;
+
+private:
+    QGVUrlTemplate::Values values(const QGV::GeoTilePos& tilePos) const;
+
+private:
+    QGVUrlTemplate mTemplate;
+    QGV::TilesScheme mScheme;
+    QStringList mSubdomains;
+    int mMinZoom;
+    int mMaxZoom;
+    QSize mTileSize;
+    QString mTileMatrixSet;
+    QStringList mTileMatrices;
+    QString mWmsCrs;
+};
@@ -19,8 +19,15 @@
 #pragma once
 
 #include "QGVLayer.h"
+#include "QGVTilesCache.h"
+#include "QGVTilesPyramid.h"
+#include "QGVTilesScheduler.h"
 
 #include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QSet>
+
+class QGVTilesCanvas;
 
 class QGV_LIB_DECL QGVLayerTiles : public QGVLayer
 {
@@ -28,6 +35,7 @@ class QGV_LIB_DECL QGVLayerTiles : public QGVLayer
 
 public:
     QGVLayerTiles();
+    ~QGVLayerTiles();
 
     void setTilesMarginWithZoomChange(size_t value);
     void setTilesMarginNoZoomChange(size_t value);
@@ -35,37 +43,97 @@ public:
     void setVisibleZoomLayersBelowCurrent(size_t value);
     void setVisibleZoomLayersAboveCurrent(size_t value);
     void setCameraUpdatesDuringAnimation(bool value);
+    void setMaxRequestsInFlight(size_t value);
+    void setPrefetchTiles(bool value);
+    void setPrefetchPanLeadMs(size_t value);
+    void setFallbackTiles(bool value);
+    void setRenderMode(QGV::TilesRenderMode value);
+
+    /*!
+     * When tiles arrive too slow to fill the view in AdaptiveFullScreenMs, tiles up to AdaptiveMaxZoomDrop levels
+     * below current zoom are requested first and shown upscaled until current level replaces them.
+     */
+    void setAdaptiveResolution(bool value);
+    void setAdaptiveFullScreenMs(size_t value);
+    void setAdaptiveMaxZoomDrop(size_t value);
+
+    /*!
+     * Tiles removed from the view are parked in the cache and revived without new request when camera returns.
+     * Cache is not owned by layer and can be shared between layers (e.g. QGVTilesCache::globalCache()),
+     * nullptr restores layer private cache.
+     */
+    void setTilesCache(QGVTilesCache* cache);
+    QGVTilesCache* getTilesCache() const;
 
 protected:
     void onProjection(QGVMap* geoMap) override;
     void onCamera(const QGVCameraState& oldState, const QGVCameraState& newState) override;
+    void onPrefetch(const QList<QGVCameraState>& targetStates) override;
     void onUpdate() override;
     void onClean() override;
     void onTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj);
+    void onTileFailed(const QGV::GeoTilePos& tilePos);
+    void reloadTiles();
+    void refreshTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj);
+    void retryFailedTiles();
 
     virtual int minZoomlevel() const = 0;
     virtual int maxZoomlevel() const = 0;
     virtual int scaleToZoom(double scale) const;
     virtual void request(const QGV::GeoTilePos& tilePos) = 0;
     virtual void cancel(const QGV::GeoTilePos& tilePos) = 0;
+    virtual QString requestHost(const QGV::GeoTilePos& tilePos) const;
+    QString requestedHost(const QGV::GeoTilePos& tilePos) const;
 
 private:
     void processCamera();
+    void queueMissingTiles();
+    void prefetchPan(const QGVCameraState& oldState, const QGVCameraState& newState);
+    QRect tilesRect(int zoom, const QRectF& projRect) const;
+    void dispatchRequests();
+    void requestCoarse(const QVector<QGV::GeoTilePos>& pending);
+    void updateArrivalRate();
+    bool isCoarseTile(const QGV::GeoTilePos& tilePos) const;
+    void insertTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj);
     void removeAllAbove(const QGV::GeoTilePos& tilePos);
     void removeWhenCovered(const QGV::GeoTilePos& tilePos);
     void removeForPerfomance(const QGV::GeoTilePos& tilePos);
     void addTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj);
     void removeTile(const QGV::GeoTilePos& tilePos);
+    void abortRequest(const QGV::GeoTilePos& tilePos);
+    void parkTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj);
+    void showTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj);
+    void hideTile(QGVDrawItem* tileObj);
+    QList<QPair<QGV::GeoTilePos, QGVDrawItem*>> shownTiles() const;
+    void deleteDetachedTiles();
+    void addPlaceholder(const QGV::GeoTilePos& tilePos);
+    void removePlaceholder(const QGV::GeoTilePos& tilePos);
+    void clearPlaceholders();
+    QImage placeholderImage(const QGV::GeoTilePos& tilePos) const;
+    QImage tileImage(const QGV::GeoTilePos& tilePos) const;
     bool isTileExists(const QGV::GeoTilePos& tilePos) const;
     bool isTileFinished(const QGV::GeoTilePos& tilePos) const;
-    QList<QGV::GeoTilePos> existingTiles(int zoom) const;
 
 private:
     int mCurZoom;
     QRect mCurRect;
-    QMap<int, QMap<QGV::GeoTilePos, QGVDrawItem*>> mIndex;
+    QGVTilesPyramid mIndex;
+    QHash<quint64, QGVDrawItem*> mPlaceholders;
+    QSet<quint64> mStale;
+    QGVTilesCanvas* mCanvas;
+    QScopedPointer<QGVTilesCache> mOwnCache;
+    QGVTilesCache* mCache;
+    QGVTilesScheduler mScheduler;
+    bool mDispatching;
+
+    int mCoarseZoom;
+    QElapsedTimer mLastArrival;
+    double mArrivalIntervalMs;
+    bool mArrivalBusy;
 
     QElapsedTimer mLastAnimation;
+    QElapsedTimer mLastPan;
+    QRect mLastPanPrefetch;
 
     struct
     {
@@ -75,5 +143,13 @@ private:
         bool CameraUpdatesDuringAnimation = true;
         size_t VisibleZoomLayersBelowCurrent = 10;
         size_t VisibleZoomLayersAboveCurrent = 10;
+        bool PrefetchTiles = true;
+        size_t PrefetchPanLeadMs = 500;
+        bool FallbackTiles = false;
+        size_t FallbackMaxZoomDelta = 6;
+        QGV::TilesRenderMode RenderMode = QGV::TilesRenderMode::Items;
+        bool AdaptiveResolution = false;
+        size_t AdaptiveFullScreenMs = 3000;
+        size_t AdaptiveMaxZoomDrop = 2;
     } mPerfomanceProfile;
 };
@@ -0,0 +1,52 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVLayerTiles.h"
+#include "QGVTilesDecoder.h"
+
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+/*!
+ * Base for tile layers which produce tiles by blocking work (file reads, decoding, rendering).
+ * Job returned by tileJob() is executed in worker pool and must not touch layer or scene, finished tiles are
+ * delivered through onTile() in GUI thread. Canceled jobs are skipped if not yet started and dropped otherwise.
+ */
+class QGV_LIB_DECL QGVLayerTilesAsync : public QGVLayerTiles
+{
+    Q_OBJECT
+
+public:
+    QGVLayerTilesAsync();
+    ~QGVLayerTilesAsync();
+
+protected:
+    virtual QGVTilesDecoder::Job tileJob(const QGV::GeoTilePos& tilePos) const = 0;
+    virtual QGVDrawItem* createTile(const QGV::GeoTilePos& tilePos, const QImage& image) const;
+
+    void request(const QGV::GeoTilePos& tilePos) override;
+    void cancel(const QGV::GeoTilePos& tilePos) override;
+
+private:
+    void onJobFinished(const QGV::GeoTilePos& tilePos, const QSharedPointer<QAtomicInt>& canceled, const QImage& image);
+
+private:
+    QMap<QGV::GeoTilePos, QSharedPointer<QAtomicInt>> mJobs;
+};
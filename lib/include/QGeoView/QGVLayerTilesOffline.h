@@ -0,0 +1,60 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVLayerTilesAsync.h"
+
+/*!
+ * Tile layer without network access, tiles are read from MBTiles file (requires Qt Sql with SQLite driver)
+ * or from z/x/y directory tree. Path template of directory tree is relative to root directory and
+ * detected automatically when possible, e.g. "${z}/${x}/${y}.png".
+ */
+class QGV_LIB_DECL QGVLayerTilesOffline : public QGVLayerTilesAsync
+{
+    Q_OBJECT
+
+public:
+    explicit QGVLayerTilesOffline(const QString& path);
+
+    QString getPath() const;
+    bool isMBTiles() const;
+    bool isValid() const;
+
+    void setPathTemplate(const QString& pathTemplate);
+    QString getPathTemplate() const;
+    void setZoomLevels(int minZoom, int maxZoom);
+
+protected:
+    int minZoomlevel() const override;
+    int maxZoomlevel() const override;
+    QGVTilesDecoder::Job tileJob(const QGV::GeoTilePos& tilePos) const override;
+
+private:
+    void openMBTiles();
+    void openDirectory();
+    static QByteArray readMBTile(const QString& path, const QGV::GeoTilePos& tilePos);
+
+private:
+    QString mPath;
+    QString mPathTemplate;
+    bool mMBTiles;
+    bool mValid;
+    int mMinZoom;
+    int mMaxZoom;
+};
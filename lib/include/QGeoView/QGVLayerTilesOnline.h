@@ -19,25 +19,54 @@
 #pragma once
 
 #include "QGVLayerTiles.h"
+#include "QGVTilesFetcher.h"
+#include "QGVTilesSeeder.h"
+#include "QGVUrlTemplate.h"
 
-#include <QNetworkReply>
-
+/*!
+ * Base for layers which download tiles by url.
+ * When provider has several mirrors (tilePosToMirrorUrls) every tile is bound to one of them by weighted
+ * rendezvous hashing: choice is stable for the tile, so HTTP caches stay effective, and slow hosts get
+ * less tiles according to QGVTilesFetcher::hostWeight(). Mirror is chosen once, when tile is queued.
+ * Tiles store id is url of root tile on first mirror unless set by setTilesStoreId(), so it doesn't depend on mirror.
+ * Tiles of area can be downloaded into tiles store in advance by seeder from seed(), it is owned by layer
+ * and starts by QGVTilesSeeder::start().
+ * Tiles refreshed by background revalidation of tiles store replace shown ones in place, tiles failed while
+ * provider was paused by circuit breaker are requested again when it resumes.
+ */
 class QGV_LIB_DECL QGVLayerTilesOnline : public QGVLayerTiles
 {
     Q_OBJECT
 
 public:
+    QGVLayerTilesOnline();
     ~QGVLayerTilesOnline();
 
+    void setLoadBalancing(bool enabled);
+    bool isLoadBalancing() const;
+
+    void setTilesStoreId(const QString& id);
+    QString getTilesStoreId() const;
+
+    QGVTilesSeeder* seed(const QGV::GeoRect& area, int fromZoom, int toZoom, int maxConcurrency = 4);
+
 protected:
     virtual QString tilePosToUrl(const QGV::GeoTilePos& tilePos) const = 0;
+    virtual QStringList tilePosToMirrorUrls(const QGV::GeoTilePos& tilePos) const;
+    static QStringList formatUrls(const QVector<QGVUrlTemplate>& templates, const QGVUrlTemplate::Values& values);
 
 private:
+    QString tileUrl(const QGV::GeoTilePos& tilePos, const QString& host = {}) const;
     void request(const QGV::GeoTilePos& tilePos) override;
     void cancel(const QGV::GeoTilePos& tilePos) override;
-    void onReplyFinished(QNetworkReply* reply, const QGV::GeoTilePos& tilePos);
-    void removeReply(const QGV::GeoTilePos& tilePos);
+    QString requestHost(const QGV::GeoTilePos& tilePos) const override;
+    void onTileFetched(const QGV::GeoTilePos& tilePos, const QString& url, const QImage& image);
+    void onTileRefreshed(const QString& storeId, const QGV::GeoTilePos& tilePos, const QImage& image);
+    void onCircuitClosed(const QString& storeId);
+    QGVDrawItem* createTile(const QGV::GeoTilePos& tilePos, const QString& url, const QImage& image) const;
 
 private:
-    QMap<QGV::GeoTilePos, QNetworkReply*> mRequest;
+    QMap<QGV::GeoTilePos, quint64> mTickets;
+    QString mStoreId;
+    bool mLoadBalancing;
 };
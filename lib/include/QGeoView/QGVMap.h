@@ -18,7 +18,9 @@
 
 #pragma once
 
+#include <QHash>
 #include <QMimeData>
+#include <QPointer>
 #include <QWidget>
 
 #include "QGVCamera.h"
@@ -40,8 +42,10 @@ public:
     ~QGVMap();
 
     const QGVCameraState getCamera() const;
+    QGV::MapState getState() const;
     void cameraTo(const QGVCameraActions& actions, bool animation = false);
     void flyTo(const QGVCameraActions& actions);
+    void prefetch(const QList<QGVCameraActions>& targets);
 
     void setProjection(QGV::Projection id);
     void setProjection(QGVProjection* projection);
@@ -85,6 +89,16 @@ public:
     void refreshProjection();
     void anchoreWidgets();
 
+    /*!
+     * Batch update: between beginUpdate() and endUpdate() changes of items only mark them dirty (see
+     * QGVItem::update), on last endUpdate() every dirty item is updated once. Items which have dirty ancestor
+     * are updated by it, so each draw item is refreshed exactly once. Calls can be nested, see QGVUpdateGuard.
+     */
+    void beginUpdate();
+    void endUpdate();
+    bool isUpdating() const;
+    void markDirty(QGVItem* item);
+
     virtual void onMapState(QGV::MapState state);
     virtual void onMapCamera(const QGVCameraState& oldState, const QGVCameraState& newState);
 
@@ -113,5 +127,21 @@ private:
     QScopedPointer<QGVItem> mRootItem;
     QList<QGVWidget*> mWidgets;
     QSet<QGVItem*> mSelections;
+    int mUpdateDepth;
+    QHash<QGVItem*, QPointer<QGVItem>> mDirtyItems;
     void handleDropDataOnQGVMapQGView(QPointF position, const QMimeData* dropData);
 };
+
+/*!
+ * Scoped batch update of map items, calls QGVMap::beginUpdate() and QGVMap::endUpdate().
+ */
+class QGV_LIB_DECL QGVUpdateGuard
+{
+public:
+    explicit QGVUpdateGuard(QGVMap* geoMap);
+    ~QGVUpdateGuard();
+
+private:
+    Q_DISABLE_COPY(QGVUpdateGuard)
+    QPointer<QGVMap> mGeoMap;
+};
@@ -48,6 +48,7 @@ public:
     double getMinScale() const;
     double getMaxScale() const;
     void setScaleLimits(double minScale, double maxScale);
+    QGV::MapState getState() const;
     void cleanState();
 
 Q_SIGNALS:
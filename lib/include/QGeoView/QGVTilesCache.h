@@ -0,0 +1,85 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QHash>
+#include <QPair>
+
+#include <list>
+
+class QGVDrawItem;
+
+class QGV_LIB_DECL QGVTilesCache
+{
+public:
+    struct Statistics
+    {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        qint64 usedBytes = 0;
+        qint64 maxBytes = 0;
+        int count = 0;
+    };
+
+    explicit QGVTilesCache(qint64 maxBytes = 32 * 1024 * 1024);
+    ~QGVTilesCache();
+
+    static QGVTilesCache* globalCache();
+
+    void setMaxBytes(qint64 maxBytes);
+    qint64 getMaxBytes() const;
+    qint64 usedBytes() const;
+    int count() const;
+
+    void insert(const QObject* owner, const QGV::GeoTilePos& tilePos, QGVDrawItem* tile);
+    QGVDrawItem* take(const QObject* owner, const QGV::GeoTilePos& tilePos);
+    void remove(const QObject* owner, const QGV::GeoTilePos& tilePos);
+    const QGVDrawItem* find(const QObject* owner, const QGV::GeoTilePos& tilePos) const;
+    bool contains(const QObject* owner, const QGV::GeoTilePos& tilePos) const;
+    void clear(const QObject* owner);
+    void clear();
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+    static qint64 tileCost(const QGVDrawItem* tile);
+
+private:
+    using Key = QPair<const QObject*, quint64>;
+    struct Node
+    {
+        Key key;
+        QGVDrawItem* tile;
+        qint64 cost;
+    };
+    using List = std::list<Node>;
+
+    void evict(qint64 maxBytes);
+
+private:
+    Q_DISABLE_COPY(QGVTilesCache)
+    qint64 mMaxBytes;
+    qint64 mUsedBytes;
+    List mLru;
+    QHash<Key, List::iterator> mNodes;
+    Statistics mStatistics;
+};
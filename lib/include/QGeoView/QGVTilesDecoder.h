@@ -0,0 +1,57 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QImage>
+#include <QThreadPool>
+
+#include <functional>
+
+/*!
+ * Worker pool used to produce tile images outside of GUI thread.
+ * Results are delivered to GUI thread and only if context object is still alive.
+ * Context is not checked by worker thread, job which should be skipped when it is no longer needed has to check
+ * its own flag (see QGVLayerTilesAsync).
+ */
+class QGV_LIB_DECL QGVTilesDecoder
+{
+public:
+    using Job = std::function<QImage()>;
+    using Callback = std::function<void(const QImage& image)>;
+
+    QGVTilesDecoder();
+    ~QGVTilesDecoder();
+
+    static QGVTilesDecoder* globalDecoder();
+
+    void setMaxThreadCount(int value);
+    int getMaxThreadCount() const;
+
+    void run(const Job& job, QObject* context, const Callback& callback);
+    void decode(const QByteArray& rawData, QObject* context, const Callback& callback);
+    void waitForDone();
+
+    static QImage decodeImage(const QByteArray& rawData);
+
+private:
+    Q_DISABLE_COPY(QGVTilesDecoder)
+    QThreadPool mPool;
+};
@@ -0,0 +1,194 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+#include "QGVTilesStore.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QMap>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QSet>
+
+#include <functional>
+
+/*!
+ * Process-wide service which fetches tiles from tiles store or network and decodes them.
+ * Concurrent requests for same tile (same store id and position) are merged into one job, decoded result is
+ * delivered to every subscriber. Job is aborted only when last subscriber cancels it.
+ * Latency and throughput of every host are tracked, hostWeight() ranks mirrors of same provider by them.
+ * Failed network requests are retried with jittered exponential backoff, missing (404) and empty tiles are
+ * remembered in negative cache, other non-transient errors (e.g. 403) are remembered for shorter time.
+ * Provider (store id) with repeated errors of any kind except missing tile is paused by circuit breaker, after
+ * timeout single probe request decides whether traffic resumes, circuitClosed() tells when it does.
+ * Tiles from store older than max age are delivered immediately and revalidated in background by conditional
+ * request with low priority; "304 Not Modified" only refreshes stored metadata, new content is stored and
+ * announced by tileRefreshed().
+ * prefetch() only puts tile into tiles store: downloaded data is written without decoding and subscriber is told
+ * whether tile is stored.
+ */
+class QGV_LIB_DECL QGVTilesFetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Request
+    {
+        QString url;
+        QString storeId;
+        QGV::GeoTilePos tilePos;
+    };
+    struct Statistics
+    {
+        quint64 requests = 0;
+        quint64 coalesced = 0;
+        quint64 fromStore = 0;
+        quint64 fromNetwork = 0;
+        quint64 failed = 0;
+        quint64 canceled = 0;
+        quint64 retries = 0;
+        quint64 negativeHits = 0;
+        quint64 rejected = 0;
+        quint64 circuitTrips = 0;
+        quint64 revalidations = 0;
+        quint64 notModified = 0;
+        quint64 refreshed = 0;
+    };
+    struct HostStatistics
+    {
+        quint64 requests = 0;
+        quint64 failed = 0;
+        quint64 bytes = 0;
+        double latencyMs = 0;
+        double bytesPerSecond = 0;
+    };
+    enum class CircuitState
+    {
+        Closed,
+        Open,
+        HalfOpen,
+    };
+    using Callback = std::function<void(const QImage& image)>;
+    using StoredCallback = std::function<void(bool stored)>;
+
+    static QGVTilesFetcher* globalFetcher();
+
+    quint64 fetch(const Request& request, QObject* subscriber, const Callback& callback);
+    quint64 prefetch(const Request& request, QObject* subscriber, const StoredCallback& callback);
+    void cancel(quint64 ticket);
+    int activeCount() const;
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+    void setMaxRetries(int value);
+    int getMaxRetries() const;
+    void setRetryDelay(int msec);
+    int getRetryDelay() const;
+    void setNegativeCacheTimeout(int msec);
+    int getNegativeCacheTimeout() const;
+    void setCircuitBreaker(int failures, int timeoutMsec);
+    void setTilesMaxAge(qint64 msec);
+    qint64 getTilesMaxAge() const;
+    CircuitState circuitState(const QString& storeId) const;
+
+    QStringList hosts() const;
+    HostStatistics hostStatistics(const QString& host) const;
+    double hostWeight(const QString& host) const;
+
+Q_SIGNALS:
+    void tileRefreshed(const QString& storeId, const QGV::GeoTilePos& tilePos, const QImage& image);
+    void circuitClosed(const QString& storeId);
+
+private:
+    using Key = QPair<QString, quint64>;
+    struct Subscriber
+    {
+        QPointer<QObject> context;
+        Callback callback;
+        StoredCallback stored;
+    };
+    struct Job
+    {
+        Request request;
+        quint64 id = 0;
+        QNetworkReply* reply = nullptr;
+        QElapsedTimer timer;
+        int attempt = 0;
+        bool probe = false;
+        bool storeOnly = false;
+        QMap<quint64, Subscriber> subscribers;
+    };
+
+    struct Revalidation
+    {
+        Request request;
+        QGVTilesStore::Metadata metadata;
+    };
+    struct Breaker
+    {
+        int failures = 0;
+        qint64 openUntil = 0;
+        bool probing = false;
+    };
+
+    QGVTilesFetcher();
+
+    quint64 subscribe(const Request& request, const Subscriber& subscriber, bool storeOnly);
+    void startStore(const Key& key);
+    void startNetwork(const Key& key);
+    void onReplyFinished(const Key& key, quint64 jobId, QNetworkReply* reply);
+    void onRetry(const Key& key, quint64 jobId);
+    void failLater(const Key& key, quint64 jobId);
+    void onDecoded(const Key& key, quint64 jobId, const QImage& image, bool fromStore);
+    void storedLater(const Key& key, quint64 jobId);
+    void finish(const Key& key, const QImage& image, bool stored = false);
+    void revalidate(const Key& key, const QGVTilesStore::Metadata& metadata);
+    void startRevalidations();
+    void onRevalidated(const Key& key, QNetworkReply* reply);
+    void writeStore(const Key& key, const QByteArray& rawImage, const QGVTilesStore::Metadata& metadata);
+    bool acquireCircuit(Job& job);
+    void reportCircuit(const QString& storeId, bool failed);
+    bool isNegative(const Key& key);
+    void insertNegative(const Key& key, int timeout);
+    void updateHost(const QString& host, qint64 elapsedMs, qint64 bytes, bool failed);
+
+private:
+    QHash<Key, Job> mJobs;
+    QHash<quint64, Key> mTickets;
+    quint64 mLastTicket;
+    quint64 mLastJob;
+    Statistics mStatistics;
+    QHash<QString, HostStatistics> mHosts;
+    QHash<QString, Breaker> mBreakers;
+    QHash<Key, qint64> mNegative;
+    QList<Revalidation> mRevalidations;
+    QSet<Key> mRevalidating;
+    int mRevalidationsActive;
+    QElapsedTimer mClock;
+    int mMaxRetries;
+    int mRetryDelay;
+    int mNegativeTimeout;
+    int mCircuitFailures;
+    int mCircuitTimeout;
+    qint64 mMaxAge;
+};
@@ -0,0 +1,59 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QHash>
+#include <QVector>
+
+class QGVDrawItem;
+
+class QGV_LIB_DECL QGVTilesPyramid
+{
+public:
+    using Level = QHash<quint64, QGVDrawItem*>;
+
+    QGVTilesPyramid();
+
+    void clear();
+    bool isEmpty() const;
+    int count() const;
+    int count(int zoom) const;
+
+    bool contains(const QGV::GeoTilePos& tilePos) const;
+    QGVDrawItem* value(const QGV::GeoTilePos& tilePos) const;
+    void insert(const QGV::GeoTilePos& tilePos, QGVDrawItem* tile);
+    QGVDrawItem* take(const QGV::GeoTilePos& tilePos);
+
+    int levels() const;
+    const Level& level(int zoom) const;
+    void keys(int zoom, QVector<QGV::GeoTilePos>& result) const;
+
+    QGV::GeoTilePos findAncestor(const QGV::GeoTilePos& tilePos, int minZoom) const;
+    void findChildren(const QGV::GeoTilePos& tilePos, QVector<QGV::GeoTilePos>& result) const;
+    void findDescendants(const QGV::GeoTilePos& tilePos, int zoom, QVector<QGV::GeoTilePos>& result) const;
+
+private:
+    bool isValidZoom(int zoom) const;
+
+private:
+    QVector<Level> mLevels;
+    int mCount;
+};
@@ -0,0 +1,98 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QHash>
+#include <QPointF>
+#include <QVector>
+
+#include <functional>
+
+/*!
+ * Queue of tile requests between QGVLayerTiles and its request() implementation.
+ * Tiles are dispatched by priority (distance to view center and zoom difference) and only while
+ * in-flight limits per layer and per host allow it. Host limits are shared between all schedulers, every host
+ * uses default limit unless it has own one.
+ * Prefetch requests (level > 0) are always ordered after visible ones, urgent requests (level < 0, e.g. coarse tiles
+ * of adaptive resolution) before them.
+ */
+class QGV_LIB_DECL QGVTilesScheduler
+{
+public:
+    using Dispatcher = std::function<void()>;
+
+    QGVTilesScheduler(QObject* owner, const Dispatcher& dispatcher);
+    ~QGVTilesScheduler();
+
+    static void setMaxRequestsPerHost(size_t value);
+    static size_t getMaxRequestsPerHost();
+    static void setMaxRequestsPerHost(const QString& host, size_t value);
+    static void resetMaxRequestsPerHost(const QString& host);
+    static size_t getMaxRequestsPerHost(const QString& host);
+    static int hostInFlightCount(const QString& host);
+
+    void setMaxRequestsInFlight(size_t value);
+    size_t getMaxRequestsInFlight() const;
+
+    void setView(int zoom, const QPointF& center);
+    void enqueue(const QGV::GeoTilePos& tilePos, const QString& host, int prefetchLevel = 0);
+    bool dequeue(const QGV::GeoTilePos& tilePos);
+    void clearPrefetch();
+    bool takeNext(QGV::GeoTilePos& tilePos);
+    void finished(const QGV::GeoTilePos& tilePos);
+    void clear();
+
+    bool isQueued(const QGV::GeoTilePos& tilePos) const;
+    bool isInFlight(const QGV::GeoTilePos& tilePos) const;
+    QString inFlightHost(const QGV::GeoTilePos& tilePos) const;
+    int queuedCount() const;
+    int inFlightCount() const;
+
+private:
+    struct Entry
+    {
+        quint64 key;
+        double priority;
+    };
+    struct Request
+    {
+        QString host;
+        int prefetchLevel;
+    };
+
+    double priority(const QGV::GeoTilePos& tilePos, int prefetchLevel) const;
+    bool isLayerSaturated() const;
+    static bool isHostSaturated(const QString& host);
+    static void releaseHost(const QString& host);
+    static void wakeAll();
+
+private:
+    Q_DISABLE_COPY(QGVTilesScheduler)
+    QObject* mOwner;
+    Dispatcher mDispatcher;
+    size_t mMaxInFlight;
+    int mZoom;
+    QPointF mCenter;
+    QHash<quint64, Request> mQueued;
+    QHash<quint64, QString> mInFlight;
+    QVector<Entry> mOrder;
+    bool mOrderDirty;
+};
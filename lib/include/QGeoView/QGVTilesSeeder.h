@@ -0,0 +1,123 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QObject>
+#include <QTimer>
+
+#include <functional>
+
+/*!
+ * Downloads every tile of geo area over range of zoom levels into tiles store (see QGV::setTilesStore).
+ * Tiles are fetched in parallel by QGVTilesFetcher::prefetch() without decoding, so retries, negative cache and
+ * circuit breaker apply as for visible tiles. Request rate is limited by token bucket and seeding waits while
+ * circuit of provider is open.
+ * Tiles which are already in store are skipped, so interrupted seeding is resumed by starting it again; position
+ * in area can also be saved by position() and passed to start().
+ */
+class QGV_LIB_DECL QGVTilesSeeder : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Progress
+    {
+        quint64 total = 0;
+        quint64 processed = 0;
+        quint64 skipped = 0;
+        quint64 downloaded = 0;
+        quint64 failed = 0;
+        quint64 bytes = 0;
+    };
+    using UrlFactory = std::function<QString(const QGV::GeoTilePos& tilePos)>;
+
+    QGVTilesSeeder(const QString& storeId, const UrlFactory& urlFactory, QObject* parent = nullptr);
+    ~QGVTilesSeeder();
+
+    void setArea(const QGV::GeoRect& area);
+    QGV::GeoRect getArea() const;
+    void setZoomRange(int fromZoom, int toZoom);
+    int getFromZoom() const;
+    int getToZoom() const;
+    void setMaxConcurrency(int value);
+    int getMaxConcurrency() const;
+    void setRateLimit(double tilesPerSecond);
+    double getRateLimit() const;
+
+    quint64 tilesCount() const;
+    qint64 estimatedBytes() const;
+
+    void start(quint64 fromPosition = 0);
+    void stop();
+    bool isRunning() const;
+    quint64 position() const;
+    Progress progress() const;
+
+Q_SIGNALS:
+    void progressChanged(const QGVTilesSeeder::Progress& progress);
+    void finished(bool completed);
+
+private:
+    struct Range
+    {
+        int zoom;
+        int left;
+        int top;
+        int right;
+        int bottom;
+        quint64 count() const;
+    };
+    struct Pending
+    {
+        quint64 ticket;
+        quint64 position;
+    };
+
+    void updateRanges();
+    QGV::GeoTilePos tileAt(quint64 position) const;
+    void pump();
+    void schedulePump(int msec);
+    bool takeToken();
+    int tokenDelay() const;
+    void onFetched(const QGV::GeoTilePos& tilePos, bool stored);
+    void finish(bool completed);
+
+private:
+    QString mStoreId;
+    UrlFactory mUrlFactory;
+    QGV::GeoRect mArea;
+    int mFromZoom;
+    int mToZoom;
+    int mMaxConcurrency;
+    double mRateLimit;
+    QVector<Range> mRanges;
+    quint64 mPosition;
+    Progress mProgress;
+    QMap<QGV::GeoTilePos, Pending> mPending;
+    bool mRunning;
+    double mTokens;
+    QElapsedTimer mRefill;
+    QTimer mPumpTimer;
+};
+
+Q_DECLARE_METATYPE(QGVTilesSeeder::Progress)
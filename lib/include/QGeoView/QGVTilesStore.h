@@ -0,0 +1,142 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMap>
+#include <QReadWriteLock>
+#include <QThreadPool>
+
+class QFile;
+
+/*!
+ * Persistent storage of raw tile data keyed by (layer id, tile position).
+ * Data is appended to pack files which are memory-mapped for reading, index is kept in memory. It is saved to
+ * index file on close and loaded on next open, record headers are scanned only when index file is missing or
+ * outdated (e.g. after crash). Reads can run concurrently from any thread, overwritten records are reclaimed by
+ * compaction in background thread. When max size is set oldest packs are evicted as whole.
+ * Every tile has metadata (time of download and HTTP validators) which is used for revalidation of stale tiles,
+ * updated metadata is appended as small record which refers to data of tile written before.
+ */
+class QGV_LIB_DECL QGVTilesStore
+{
+public:
+    struct Metadata
+    {
+        qint64 timestamp = 0;
+        QByteArray etag;
+        QByteArray lastModified;
+    };
+
+    explicit QGVTilesStore(const QString& directory, qint64 maxPackSize = 64 * 1024 * 1024);
+    ~QGVTilesStore();
+
+    QString getDirectory() const;
+    bool isOpen() const;
+
+    bool contains(const QString& layerId, const QGV::GeoTilePos& tilePos) const;
+    qint64 dataSize(const QString& layerId, const QGV::GeoTilePos& tilePos) const;
+    QByteArray read(const QString& layerId, const QGV::GeoTilePos& tilePos, Metadata* metadata = nullptr) const;
+    bool readMetadata(const QString& layerId, const QGV::GeoTilePos& tilePos, Metadata& metadata) const;
+    bool write(const QString& layerId,
+               const QGV::GeoTilePos& tilePos,
+               const QByteArray& data,
+               const Metadata& metadata = {});
+    bool updateMetadata(const QString& layerId, const QGV::GeoTilePos& tilePos, const Metadata& metadata);
+
+    int count() const;
+    qint64 liveBytes() const;
+    qint64 totalBytes() const;
+
+    void setMaxSize(qint64 bytes);
+    qint64 getMaxSize() const;
+
+    void setCompactionThreshold(double garbageRatio);
+    double getCompactionThreshold() const;
+    void compact();
+    void compactInBackground();
+    void waitForCompaction();
+
+private:
+    struct Pack
+    {
+        quint32 number;
+        QFile* file;
+        uchar* map;
+        qint64 mapSize;
+        qint64 liveBytes;
+    };
+    struct Location
+    {
+        quint32 pack;
+        quint32 size;
+        qint64 offset;
+        quint32 metaPack;
+        qint64 metaOffset;
+        quint16 metaSize;
+    };
+    using Key = QPair<quint32, quint64>;
+
+    void open();
+    bool loadIndex(const QList<quint32>& numbers);
+    void saveIndex() const;
+    bool openPack(quint32 number, bool scan = true);
+    void scanPack(Pack* pack);
+    Pack* activePack(qint64 recordSize);
+    bool append(Pack* pack,
+                const QString& layerId,
+                quint64 tileKey,
+                const QByteArray& meta,
+                const QByteArray& data,
+                quint16 flags,
+                Location& location);
+    bool store(const QString& layerId, quint64 tileKey, const QByteArray& meta, const QByteArray& data);
+    bool remap(Pack* pack) const;
+    bool copyData(const Location& location, QByteArray& data) const;
+    bool copyMeta(const Location& location, QByteArray& meta) const;
+    bool readRecord(const QString& layerId, quint64 tileKey, QByteArray* data, QByteArray* meta) const;
+    const Location* find(const QString& layerId, quint64 tileKey) const;
+    void closePack(Pack* pack, bool remove);
+    void compactPack(quint32 number);
+    void evict();
+    void dropPack(quint32 number);
+    bool releaseData(const Location& location, const Pack* active);
+    bool releaseMeta(const Location& location, const Pack* active);
+    bool release(quint32 number, qint64 bytes, const Pack* active);
+    quint32 layerIndex(const QString& layerId);
+    QString packPath(quint32 number) const;
+    QString indexPath() const;
+
+private:
+    Q_DISABLE_COPY(QGVTilesStore)
+    QString mDirectory;
+    qint64 mMaxPackSize;
+    qint64 mMaxSize;
+    double mCompactionThreshold;
+    bool mOpen;
+    mutable QReadWriteLock mLock;
+    QMap<quint32, Pack*> mPacks;
+    QHash<QString, quint32> mLayers;
+    QHash<Key, Location> mIndex;
+    QThreadPool mCompactionPool;
+    QAtomicInt mCompactionQueued;
+};
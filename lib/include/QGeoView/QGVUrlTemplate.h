@@ -0,0 +1,93 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QRectF>
+#include <QSize>
+#include <QStringList>
+#include <QVector>
+
+/*!
+ * Url template which is parsed once and then formatted for every tile in one pass.
+ * Supported placeholders (also in legacy form ${name}):
+ * {s} subdomain, {z} {x} {y} tile position, {-y} TMS row, {q} quad key, {lcl} locale,
+ * {bbox} {w} {h} WMS bounding box (minx,miny,maxx,maxy) and image size,
+ * {TileMatrixSet} {TileMatrix} {TileRow} {TileCol} WMTS tile address.
+ * Unknown placeholders are kept as text.
+ */
+class QGV_LIB_DECL QGVUrlTemplate
+{
+public:
+    enum class Field
+    {
+        Text,
+        Subdomain,
+        Zoom,
+        X,
+        Y,
+        FlippedY,
+        QuadKey,
+        Locale,
+        BBox,
+        Width,
+        Height,
+        TileMatrixSet,
+        TileMatrix,
+    };
+
+    struct Values
+    {
+        QGV::GeoTilePos tilePos;
+        bool flipY = false;
+        QString subdomain;
+        QString locale;
+        QRectF bbox;
+        QSize size;
+        QString tileMatrixSet;
+        QStringList tileMatrices;
+    };
+
+    QGVUrlTemplate();
+    explicit QGVUrlTemplate(const QString& text);
+
+    QString text() const;
+    bool isEmpty() const;
+    bool has(Field field) const;
+
+    QString format(const Values& values) const;
+    void format(const Values& values, QString& buffer) const;
+
+private:
+    struct Segment
+    {
+        Field field;
+        QString text;
+    };
+
+    void parse();
+    void append(const Segment& segment, const Values& values, QString& buffer) const;
+
+private:
+    QString mText;
+    QVector<Segment> mSegments;
+    int mFields;
+    int mSizeHint;
+};
@@ -0,0 +1,75 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include <QGeoView/QGVLayerTilesAsync.h>
+
+#include <QBrush>
+
+/*!
+ * Gridded scalar data (elevation, temperature, signal strength) colorized by color ramp.
+ * Grid of float values covers geo rect in geographic coordinates (EPSG:4326, row 0 is north edge); NaN and
+ * optional nodata value are transparent. Only visible tiles of current zoom are rendered in worker threads,
+ * values are mapped to ramp by SSE2 kernel (scalar fallback) and 256 entries lookup table. Change of ramp or
+ * value range re-renders shown tiles in place, old tiles stay visible until replaced.
+ */
+class QGV_LIB_DECL QGVGridCoverage : public QGVLayerTilesAsync
+{
+    Q_OBJECT
+
+public:
+    QGVGridCoverage();
+
+    void setGrid(const QVector<float>& values, int width, int height, const QGV::GeoRect& geoRect);
+    QVector<float> getValues() const;
+    QSize getGridSize() const;
+    QGV::GeoRect getGeometry() const;
+
+    void setColorRamp(const QGradientStops& stops);
+    QGradientStops getColorRamp() const;
+    void setValueRange(float minValue, float maxValue);
+    float getMinValue() const;
+    float getMaxValue() const;
+    void setNoDataValue(float value);
+    void resetNoDataValue();
+
+    void setZoomLevels(int minZoom, int maxZoom);
+
+protected:
+    int minZoomlevel() const override;
+    int maxZoomlevel() const override;
+    QGVTilesDecoder::Job tileJob(const QGV::GeoTilePos& tilePos) const override;
+
+private:
+    void updateLookup();
+
+private:
+    QVector<float> mValues;
+    QSize mGridSize;
+    QGV::GeoRect mGeoRect;
+    QGradientStops mRamp;
+    QVector<quint32> mLookup;
+    float mMinValue;
+    float mMaxValue;
+    float mNoData;
+    bool mHasNoData;
+    bool mAutoZoom;
+    int mMinZoom;
+    int mMaxZoom;
+};
@@ -0,0 +1,81 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include <QGeoView/QGVDrawItem.h>
+
+#include <QPainter>
+#include <QPixmap>
+
+/*!
+ * Single draw item for large amount of icons (markers).
+ * Positions and sprite ids of icons are stored in contiguous arrays, distinct images (sprites) are packed into
+ * one atlas pixmap. Icons are culled against viewport and all visible ones are drawn in screen space by single
+ * drawPixmapFragments() call; like QGVIcon they ignore scale and azimuth of camera.
+ * Removing icon moves last icon to its index.
+ */
+class QGV_LIB_DECL QGVIconBatch : public QGVDrawItem
+{
+    Q_OBJECT
+
+public:
+    QGVIconBatch();
+
+    int addSprite(const QImage& image, const QSizeF& size = QSizeF());
+    int countSprites() const;
+
+    int addIcon(const QGV::GeoPos& geoPos, int sprite);
+    void setIcons(const QVector<QGV::GeoPos>& positions, const QVector<int>& sprites);
+    void setIconPos(int index, const QGV::GeoPos& geoPos);
+    void setIconSprite(int index, int sprite);
+    QGV::GeoPos getIconPos(int index) const;
+    int getIconSprite(int index) const;
+    void removeIcon(int index);
+    int countIcons() const;
+    void clear();
+
+protected:
+    void onProjection(QGVMap* geoMap) override;
+    QGraphicsItem::CacheMode projCacheMode() const override;
+    QPainterPath projShape() const override;
+    void projPaint(QPainter* painter) override;
+    QString projDebug() override;
+
+private:
+    struct Sprite
+    {
+        QImage image;
+        QSizeF size;
+        QRect atlasRect;
+    };
+
+    void buildAtlas();
+    QPointF toProj(const QGV::GeoPos& geoPos) const;
+
+private:
+    QVector<Sprite> mSprites;
+    QPixmap mAtlas;
+    bool mAtlasDirty;
+    QSizeF mMaxSpriteSize;
+    QVector<QGV::GeoPos> mGeoPos;
+    QVector<QPointF> mProjPos;
+    QVector<int> mSpriteIds;
+    QVector<QPainter::PixmapFragment> mFragments;
+    int mVisibleCount;
+};
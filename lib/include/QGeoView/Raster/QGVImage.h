@@ -20,6 +20,20 @@
 
 #include <QGeoView/QGVDrawItem.h>
 
+#include <QAtomicInteger>
+#include <QPixmap>
+#include <QSharedPointer>
+#include <QTimer>
+
+/*!
+ * Image placed on map.
+ * Image is painted from device-ready pixmap, copy pre-scaled to current zoom is kept and rebuilt only when
+ * scale crosses bucket boundary or settles on new value, so panning of static image is plain blit.
+ * Decoded high resolution region is painted same way.
+ * Asynchronous loading decodes preview sized to on-screen footprint first, then region visible in camera is
+ * decoded with higher resolution when needed (QImageReader clip rect and scaled size), nothing blocks GUI thread.
+ * Region is requested once map is idle, request superseded before its decoding starts is skipped.
+ */
 class QGV_LIB_DECL QGVImage : public QGVDrawItem
 {
     Q_OBJECT
@@ -35,16 +49,43 @@ public:
 
     void loadImage(const QByteArray& rawData);
     void loadImage(const QImage& image);
+    void loadImageAsync(const QByteArray& rawData);
+    void loadImageAsync(const QString& fileName);
+    bool isLoading() const;
 
     void setCeilingOnScale(bool enabled);
 
+    /*!
+     * Drops pixmaps made for painting (e.g. while item is not shown), they are rebuilt from image on next paint.
+     */
+    void releasePixmaps();
+
 protected:
     void onProjection(QGVMap* geoMap) override;
+    void onCamera(const QGVCameraState& oldState, const QGVCameraState& newState) override;
+    QGraphicsItem::CacheMode projCacheMode() const override;
     QPainterPath projShape() const override;
     void projPaint(QPainter* painter) override;
 
 private:
+    struct Scaled
+    {
+        QPixmap pixmap;
+        int bucket = 0;
+        QSize lastDeviceSize;
+    };
+
     void calculateGeometry();
+    void paintPixmap(QPainter* painter, const QRectF& paintRect, const QPixmap& source, Scaled& scaled);
+    void initDetail();
+    void startProgressive();
+    void requestPreview();
+    void requestDetail();
+    void onDetailTimer();
+    void onPreview(quint64 generation, const QImage& image);
+    void onDetail(quint64 generation, quint64 request, const QImage& image, const QRectF& projRect, bool full);
+    const QPixmap& scaledPixmap(const QPixmap& pixmap, Scaled& scaled, const QSize& deviceSize, qreal pixelRatio);
+    void resetPixmaps();
 
 private:
     QGV::GeoRect mGeoRect;
@@ -52,5 +93,20 @@ private:
 
     QString mUrl;
     QImage mImage;
+    QPixmap mPixmap;
+    Scaled mScaled;
+
+    QByteArray mSourceData;
+    QString mSourceFile;
+    QSize mSourceSize;
+    quint64 mGeneration;
+    quint64 mDetailRequest;
+    QSharedPointer<QAtomicInteger<quint64>> mLatestDetail;
+    QTimer* mDetailTimer;
+    bool mLoading;
+    QPixmap mDetail;
+    Scaled mDetailScaled;
+    QRectF mDetailProjRect;
+    QRectF mRequestedProjRect;
     bool mCeilingOnScale;
 };
@@ -0,0 +1,68 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include <QGeoView/QGVLayerTilesAsync.h>
+
+#include <QSharedPointer>
+
+class QGVImageTilesSource;
+
+/*!
+ * Georeferenced image of any size shown as tile pyramid.
+ * Every map tile is produced in worker thread from region of image file: formats which support clip and scaled
+ * reads (e.g. JPEG) are read by QImageReader directly. For others overviews of halved resolution are built once in
+ * background and kept as chunks in tiles store (QGV::getTilesStore(), private temporary store when none is set),
+ * chunks are reused while file is unchanged. Build reads image by rows of chunks when format supports clip reads,
+ * otherwise (e.g. TIFF) whole image is decoded once, so it must fit in memory and in QImageReader allocation limit.
+ * Tiles requested before overviews are ready fail and are requested again when build finishes.
+ * Only visible tiles of current zoom stay in memory as for any tile layer.
+ */
+class QGV_LIB_DECL QGVImageTiles : public QGVLayerTilesAsync
+{
+    Q_OBJECT
+
+public:
+    QGVImageTiles(const QString& fileName, const QGV::GeoRect& geoRect);
+    ~QGVImageTiles();
+
+    QString getFileName() const;
+    QGV::GeoRect getGeometry() const;
+    QSize getImageSize() const;
+    bool isValid() const;
+    bool isRegionReads() const;
+    bool isReady() const;
+
+    void setZoomLevels(int minZoom, int maxZoom);
+
+protected:
+    int minZoomlevel() const override;
+    int maxZoomlevel() const override;
+    QGVTilesDecoder::Job tileJob(const QGV::GeoTilePos& tilePos) const override;
+
+private:
+    void onOverviewsBuilt();
+
+private:
+    QSharedPointer<QGVImageTilesSource> mSource;
+    QGV::GeoRect mGeoRect;
+    QRectF mWorldRect;
+    int mMinZoom;
+    int mMaxZoom;
+};
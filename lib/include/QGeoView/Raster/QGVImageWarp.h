@@ -0,0 +1,56 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include <QGeoView/QGVLayerTilesAsync.h>
+
+/*!
+ * Raster in geographic coordinates (EPSG:4326, latitude and longitude linear in image) warped into map tiles.
+ * Unlike QGVImage, which stretches image linearly over projected rect, rows are resampled by latitude so
+ * weather, radar and satellite products stay in place towards poles. Tiles are warped in worker threads
+ * with per-row latitude lookup table and SSE2 row blending (scalar fallback), warped tiles are kept by layer
+ * and its cache, so frame is processed once and not on every paint. New frame replaces tiles in place.
+ */
+class QGV_LIB_DECL QGVImageWarp : public QGVLayerTilesAsync
+{
+    Q_OBJECT
+
+public:
+    QGVImageWarp();
+
+    void setImage(const QImage& image, const QGV::GeoRect& geoRect);
+    QImage getImage() const;
+    QGV::GeoRect getGeometry() const;
+
+    void setZoomLevels(int minZoom, int maxZoom);
+
+    static QImage warpTile(const QImage& image, const QGV::GeoRect& geoRect, const QGV::GeoTilePos& tilePos);
+
+protected:
+    int minZoomlevel() const override;
+    int maxZoomlevel() const override;
+    QGVTilesDecoder::Job tileJob(const QGV::GeoTilePos& tilePos) const override;
+
+private:
+    QImage mImage;
+    QGV::GeoRect mGeoRect;
+    bool mAutoZoom;
+    int mMinZoom;
+    int mMaxZoom;
+};
@@ -5,6 +5,11 @@ QT += gui widgets network
 
 DEFINES += QGV_EXPORT
 
+qtHaveModule(sql) {
+    QT += sql
+    DEFINES += QGV_MBTILES
+}
+
 HEADERS += \
     $$PWD/include/QGeoView/QGVCamera.h \
     $$PWD/include/QGeoView/QGVDrawItem.h \
@@ -18,6 +23,17 @@ HEADERS += \
     $$PWD/include/QGeoView/QGVLayerBDGEx.h \
     $$PWD/include/QGeoView/QGVLayerTiles.h \
     $$PWD/include/QGeoView/QGVLayerTilesOnline.h \
+    $$PWD/include/QGeoView/QGVTilesPyramid.h \
+    $$PWD/include/QGeoView/QGVTilesCache.h \
+    $$PWD/include/QGeoView/QGVTilesDecoder.h \
+    $$PWD/include/QGeoView/QGVTilesScheduler.h \
+    $$PWD/include/QGeoView/QGVTilesStore.h \
+    $$PWD/include/QGeoView/QGVTilesFetcher.h \
+    $$PWD/include/QGeoView/QGVLayerTilesAsync.h \
+    $$PWD/include/QGeoView/QGVLayerTilesOffline.h \
+    $$PWD/include/QGeoView/QGVUrlTemplate.h \
+    $$PWD/include/QGeoView/QGVLayerTemplate.h \
+    $$PWD/include/QGeoView/QGVTilesSeeder.h \
     $$PWD/include/QGeoView/QGVMap.h \
     $$PWD/include/QGeoView/QGVMapQGItem.h \
     $$PWD/include/QGeoView/QGVMapQGView.h \
@@ -30,7 +46,11 @@ HEADERS += \
     $$PWD/include/QGeoView/QGVWidgetText.h \
     $$PWD/include/QGeoView/QGVWidgetZoom.h \
     $$PWD/include/QGeoView/Raster/QGVImage.h \
+    $$PWD/include/QGeoView/Raster/QGVImageTiles.h \
+    $$PWD/include/QGeoView/Raster/QGVImageWarp.h \
+    $$PWD/include/QGeoView/Raster/QGVGridCoverage.h \
     $$PWD/include/QGeoView/Raster/QGVIcon.h \
+    $$PWD/include/QGeoView/Raster/QGVIconBatch.h \
 
 SOURCES += \
     $$PWD/src/QGVCamera.cpp \
@@ -45,6 +65,17 @@ SOURCES += \
     $$PWD/src/QGVLayerBDGEx.cpp \
     $$PWD/src/QGVLayerTiles.cpp \
     $$PWD/src/QGVLayerTilesOnline.cpp \
+    $$PWD/src/QGVTilesPyramid.cpp \
+    $$PWD/src/QGVTilesCache.cpp \
+    $$PWD/src/QGVTilesDecoder.cpp \
+    $$PWD/src/QGVTilesScheduler.cpp \
+    $$PWD/src/QGVTilesStore.cpp \
+    $$PWD/src/QGVTilesFetcher.cpp \
+    $$PWD/src/QGVLayerTilesAsync.cpp \
+    $$PWD/src/QGVLayerTilesOffline.cpp \
+    $$PWD/src/QGVUrlTemplate.cpp \
+    $$PWD/src/QGVLayerTemplate.cpp \
+    $$PWD/src/QGVTilesSeeder.cpp \
     $$PWD/src/QGVMap.cpp \
     $$PWD/src/QGVMapQGItem.cpp \
     $$PWD/src/QGVMapQGView.cpp \
@@ -57,7 +88,11 @@ SOURCES += \
     $$PWD/src/QGVWidgetText.cpp \
     $$PWD/src/QGVWidgetZoom.cpp \
     $$PWD/src/Raster/QGVImage.cpp \
-    $$PWD/src/Raster/QGVIcon.cpp
+    $$PWD/src/Raster/QGVImageTiles.cpp \
+    $$PWD/src/Raster/QGVImageWarp.cpp \
+    $$PWD/src/Raster/QGVGridCoverage.cpp \
+    $$PWD/src/Raster/QGVIcon.cpp \
+    $$PWD/src/Raster/QGVIconBatch.cpp
 
 INCLUDEPATH += \
     $$PWD/include/ \
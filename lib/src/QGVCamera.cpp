@@ -215,6 +215,7 @@ QPointF QGVCameraActions::projCenter() const
 QGVCameraAnimation::QGVCameraAnimation(const QGVCameraActions& actions, QObject* parent)
     : QAbstractAnimation(parent)
     , mDuration(1000)
+    , mPrefetch(true)
     , mActions(actions)
 {
 }
@@ -229,6 +230,16 @@ int QGVCameraAnimation::duration() const
     return mDuration;
 }
 
+void QGVCameraAnimation::setPrefetch(bool enabled)
+{
+    mPrefetch = enabled;
+}
+
+bool QGVCameraAnimation::isPrefetch() const
+{
+    return mPrefetch;
+}
+
 QGVCameraActions& QGVCameraAnimation::actions()
 {
     return mActions;
@@ -242,6 +253,11 @@ void QGVCameraAnimation::onStop()
 {
 }
 
+QList<QGVCameraActions> QGVCameraAnimation::prefetchTargets()
+{
+    return { mActions };
+}
+
 double QGVCameraAnimation::interpolateScale(double from, double to, double progress)
 {
     if (qFuzzyCompare(from, to)) {
@@ -278,6 +294,9 @@ void QGVCameraAnimation::updateState(QAbstractAnimation::State newState, QAbstra
         mActions.rebase(geoMap->getCamera());
         connect(geoMap, &QGVMap::stateChanged, this, &QGVCameraAnimation::onStateChanged);
         onStart();
+        if (mPrefetch) {
+            geoMap->prefetch(prefetchTargets());
+        }
     }
     if (newState == QAbstractAnimation::Stopped && oldState != QAbstractAnimation::Stopped) {
         disconnect(geoMap, nullptr, this, nullptr);
@@ -349,6 +368,15 @@ void QGVCameraFlyAnimation::onStart()
     mFlyAnchor = interpolatePos(actions().origin().projCenter(), actions().projCenter(), 0.5);
 }
 
+QList<QGVCameraActions> QGVCameraFlyAnimation::prefetchTargets()
+{
+    QGVCameraActions flyTop(actions());
+    flyTop.reset();
+    flyTop.scaleTo(mFlyScale);
+    flyTop.moveTo(mFlyAnchor);
+    return { actions(), flyTop };
+}
+
 void QGVCameraFlyAnimation::onProgress(double progress, QGVCameraActions& target)
 {
     const auto moveCurve = QEasingCurve(QEasingCurve::InQuint);
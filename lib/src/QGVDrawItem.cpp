@@ -147,6 +147,11 @@ QTransform QGVDrawItem::projTransform() const
     return {};
 }
 
+QGraphicsItem::CacheMode QGVDrawItem::projCacheMode() const
+{
+    return QGraphicsItem::DeviceCoordinateCache;
+}
+
 QString QGVDrawItem::projTooltip(const QPointF& /*projPos*/) const
 {
     return {};
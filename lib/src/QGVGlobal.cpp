@@ -27,6 +27,7 @@ namespace {
 bool drawDebugEnabled = false;
 bool printDebugEnabled = false;
 QNetworkAccessManager* networkManager = nullptr;
+QGVTilesStore* tilesStore = nullptr;
 }
 
 namespace QGV {
@@ -341,6 +342,26 @@ GeoTilePos GeoTilePos::parent(int parentZoom) const
     return GeoTilePos(parentZoom, QPoint(x, y));
 }
 
+/*!
+ * Packed 64-bit key of tile.
+ * Layout: zoom (5 bits), x (29 bits), y (29 bits). Keys of the same zoom are ordered same way as operator<.
+ */
+quint64 GeoTilePos::toKey() const
+{
+    const quint64 mask = (Q_UINT64_C(1) << 29) - 1;
+    return (static_cast<quint64>(mZoom & 0x1F) << 58) | ((static_cast<quint64>(mPos.x()) & mask) << 29) |
+           (static_cast<quint64>(mPos.y()) & mask);
+}
+
+GeoTilePos GeoTilePos::fromKey(quint64 key)
+{
+    const quint64 mask = (Q_UINT64_C(1) << 29) - 1;
+    const int zoom = static_cast<int>((key >> 58) & 0x1F);
+    const int x = static_cast<int>((key >> 29) & mask);
+    const int y = static_cast<int>(key & mask);
+    return GeoTilePos(zoom, QPoint(x, y));
+}
+
 GeoRect GeoTilePos::toGeoRect() const
 {
     const auto leftTop = [](const GeoTilePos& tilePos) -> GeoPos {
@@ -461,6 +482,16 @@ QNetworkAccessManager* getNetworkManager()
     return networkManager;
 }
 
+void setTilesStore(QGVTilesStore* store)
+{
+    tilesStore = store;
+}
+
+QGVTilesStore* getTilesStore()
+{
+    return tilesStore;
+}
+
 } // namespace QGV
 
 QDebug operator<<(QDebug debug, const QGV::GeoPos& value)
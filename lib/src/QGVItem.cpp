@@ -27,6 +27,11 @@ QGVItem::QGVItem(QGVItem* parent)
     mVisible = true;
     mSelectable = false;
     mSelected = false;
+    mEffectiveValid = false;
+    mEffectiveVisible = true;
+    mEffectiveZValue = 0;
+    mEffectiveOpacity = 1.0;
+    mChildZRange = 1.0;
 }
 
 QGVItem::~QGVItem()
@@ -48,6 +53,7 @@ void QGVItem::setParent(QGVItem* item)
     }
     auto oldParent = mParent;
     mParent = item;
+    invalidateEffective();
     if (mParent != nullptr) {
         mParent->mChildrens.append(this);
     }
@@ -115,6 +121,7 @@ void QGVItem::setZValue(qint16 zValue)
 {
     if (mZValue != zValue) {
         mZValue = zValue;
+        invalidateEffective();
         update();
     }
 }
@@ -127,12 +134,14 @@ qint16 QGVItem::getZValue() const
 void QGVItem::bringToFront()
 {
     mZValue = std::numeric_limits<decltype(mZValue)>::max();
+    invalidateEffective();
     update();
 }
 
 void QGVItem::sendToBack()
 {
     mZValue = std::numeric_limits<decltype(mZValue)>::min();
+    invalidateEffective();
     update();
 }
 
@@ -143,6 +152,7 @@ void QGVItem::setOpacity(double value)
         return;
     }
     mOpacity = value;
+    invalidateEffective();
     update();
 }
 
@@ -206,6 +216,7 @@ void QGVItem::setVisible(bool visible)
         return;
     }
     mVisible = visible;
+    invalidateEffective();
     update();
 }
 
@@ -226,37 +237,30 @@ void QGVItem::hide()
 
 double QGVItem::effectiveZValue() const
 {
-    if (mParent == nullptr) {
-        return mZValue;
-    }
-    const auto den = std::numeric_limits<decltype(mZValue)>::max() - std::numeric_limits<decltype(mZValue)>::min();
-    double range = 1.0;
-    for (QGVItem* obj = mParent->getParent(); obj != nullptr; obj = obj->getParent()) {
-        range *= 1.0 / den;
-    }
-    const double efZValue = range * mZValue / den;
-    return mParent->effectiveZValue() + efZValue;
+    updateEffective();
+    return mEffectiveZValue;
 }
 
 double QGVItem::effectiveOpacity() const
 {
-    if (mParent == nullptr) {
-        return mOpacity;
-    }
-    return mOpacity * mParent->effectiveOpacity();
+    updateEffective();
+    return mEffectiveOpacity;
 }
 
 bool QGVItem::effectivelyVisible() const
 {
-    if (mParent == nullptr) {
-        return mVisible;
-    }
-    return mVisible && mParent->effectivelyVisible();
+    updateEffective();
+    return mEffectiveVisible;
 }
 
 void QGVItem::update()
 {
-    if (getMap() == nullptr) {
+    auto geoMap = getMap();
+    if (geoMap == nullptr) {
+        return;
+    }
+    if (geoMap->isUpdating()) {
+        geoMap->markDirty(this);
         return;
     }
     for (QGVItem* obj : mChildrens) {
@@ -265,6 +269,61 @@ void QGVItem::update()
     onUpdate();
 }
 
+void QGVItem::beginUpdate()
+{
+    // Batch is ended on map which opened it, even if item is moved to other map meanwhile
+    auto geoMap = getMap();
+    mUpdateMaps.append(geoMap);
+    if (geoMap != nullptr) {
+        geoMap->beginUpdate();
+    }
+}
+
+void QGVItem::endUpdate()
+{
+    if (mUpdateMaps.isEmpty()) {
+        return;
+    }
+    const QPointer<QGVMap> geoMap = mUpdateMaps.takeLast();
+    if (!geoMap.isNull()) {
+        geoMap->endUpdate();
+    }
+}
+
+void QGVItem::updateEffective() const
+{
+    if (mEffectiveValid) {
+        return;
+    }
+    if (mParent == nullptr) {
+        mEffectiveZValue = mZValue;
+        mEffectiveOpacity = mOpacity;
+        mEffectiveVisible = mVisible;
+        mChildZRange = 1.0;
+    } else {
+        // Every level of tree gets own sub-range of z-value of its parent
+        const auto den = std::numeric_limits<decltype(mZValue)>::max() - std::numeric_limits<decltype(mZValue)>::min();
+        mParent->updateEffective();
+        mEffectiveZValue = mParent->mEffectiveZValue + mParent->mChildZRange * mZValue / den;
+        mEffectiveOpacity = mOpacity * mParent->mEffectiveOpacity;
+        mEffectiveVisible = mVisible && mParent->mEffectiveVisible;
+        mChildZRange = mParent->mChildZRange / den;
+    }
+    mEffectiveValid = true;
+}
+
+void QGVItem::invalidateEffective()
+{
+    if (!mEffectiveValid) {
+        // Descendants of invalid item can't be valid
+        return;
+    }
+    mEffectiveValid = false;
+    for (QGVItem* obj : mChildrens) {
+        obj->invalidateEffective();
+    }
+}
+
 void QGVItem::onProjection(QGVMap* geoMap)
 {
     for (QGVItem* obj : mChildrens) {
@@ -281,6 +340,15 @@ void QGVItem::onCamera(const QGVCameraState& oldState, const QGVCameraState& new
     }
 }
 
+void QGVItem::onPrefetch(const QList<QGVCameraState>& targetStates)
+{
+    for (QGVItem* obj : mChildrens) {
+        if (obj->isVisible()) {
+            obj->onPrefetch(targetStates);
+        }
+    }
+}
+
 void QGVItem::onUpdate()
 {
 }
@@ -18,70 +18,67 @@
 
 #include "QGVLayerBDGEx.h"
 
-#include <QtMath>
-
 namespace {
 // clang-format off
 const QStringList URLTemplates = {
-    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm25&srs=EPSG%3A4326&bbox=lonLeft,latBottom,lonRight,latTop&width=WIDTH&height=HEIGHT&format=image%2Fpng",
-    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm50&srs=EPSG%3A4326&bbox=lonLeft,latBottom,lonRight,latTop&width=WIDTH&height=HEIGHT&format=image%2Fpng",
-    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm100&srs=EPSG%3A4326&bbox=lonLeft,latBottom,lonRight,latTop&width=WIDTH&height=HEIGHT&format=image%2Fpng",
-    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm250&srs=EPSG%3A4326&bbox=lonLeft,latBottom,lonRight,latTop&width=WIDTH&height=HEIGHT&format=image%2Fpng",
-    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm250&srs=EPSG%3A4326&bbox=lonLeft,latBottom,lonRight,latTop&width=WIDTH&height=HEIGHT&format=image%2Fpng",
-    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctmmultiescalas&srs=EPSG%3A4326&bbox=lonLeft,latBottom,lonRight,latTop&width=WIDTH&height=HEIGHT&format=image%2Fpng",
-    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctmmultiescalas_mercator&srs=EPSG%3A3857&bbox=lonLeft,latBottom,lonRight,latTop&width=WIDTH&height=HEIGHT&format=image%2Fpng"
+    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm25&srs=EPSG%3A4326&bbox={bbox}&width={w}&height={h}&format=image%2Fpng",
+    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm50&srs=EPSG%3A4326&bbox={bbox}&width={w}&height={h}&format=image%2Fpng",
+    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm100&srs=EPSG%3A4326&bbox={bbox}&width={w}&height={h}&format=image%2Fpng",
+    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm250&srs=EPSG%3A4326&bbox={bbox}&width={w}&height={h}&format=image%2Fpng",
+    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctm250&srs=EPSG%3A4326&bbox={bbox}&width={w}&height={h}&format=image%2Fpng",
+    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctmmultiescalas&srs=EPSG%3A4326&bbox={bbox}&width={w}&height={h}&format=image%2Fpng",
+    "http://bdgex.eb.mil.br/mapcache?request=GetMap&service=WMS&version=1.1.1&layers=ctmmultiescalas_mercator&srs=EPSG%3A3857&bbox={bbox}&width={w}&height={h}&format=image%2Fpng"
 };
 // clang-format on
+
+const int imageWidth = 900;
+
+QString fromLegacyUrl(QString url)
+{
+    // Urls before template engine used plain words as placeholders
+    url.replace("lonLeft,latBottom,lonRight,latTop", "{bbox}");
+    url.replace("WIDTH", "{w}");
+    url.replace("HEIGHT", "{h}");
+    return url;
+}
+
+QString wmsCrs(const QString& url)
+{
+    return url.contains("EPSG%3A3857", Qt::CaseInsensitive) ? "EPSG:3857" : "EPSG:4326";
+}
 }
 
 QGVLayerBDGEx::QGVLayerBDGEx(int serverNumber)
-    : mUrl(URLTemplates.value(serverNumber))
+    : QGVLayerTemplate(URLTemplates.value(serverNumber), QGV::TilesScheme::WMS)
+    , mUrl(URLTemplates.value(serverNumber))
 {
     setName("Banco de Dados Geográfico do Exército");
     setDescription("Copyrights: \"Termo de Uso do BDGEx\"");
+    setZoomRange(0, 20);
+    setTileSize(QSize(imageWidth, imageWidth));
+    setWmsCrs(wmsCrs(getUrlTemplate()));
 }
 
 QGVLayerBDGEx::QGVLayerBDGEx(const QString& url)
-    : mUrl(url)
+    : QGVLayerTemplate(fromLegacyUrl(url), QGV::TilesScheme::WMS)
+    , mUrl(url)
 {
     setName("Padrão");
     setDescription("Carta Topográfica Matricial");
+    setZoomRange(0, 20);
+    setTileSize(QSize(imageWidth, imageWidth));
+    setWmsCrs(wmsCrs(getUrlTemplate()));
 }
 
 void QGVLayerBDGEx::setUrl(const QString& url)
 {
     mUrl = url;
+    setUrlTemplate(fromLegacyUrl(url));
+    setWmsCrs(wmsCrs(getUrlTemplate()));
 }
 
 QString QGVLayerBDGEx::getUrl() const
 {
+    // Url as given by caller, template may be converted from legacy placeholders
     return mUrl;
 }
-
-int QGVLayerBDGEx::minZoomlevel() const
-{
-    return 0;
-}
-
-int QGVLayerBDGEx::maxZoomlevel() const
-{
-    return 20;
-}
-
-QString QGVLayerBDGEx::tilePosToUrl(const QGV::GeoTilePos& tilePos) const
-{
-    QString url = mUrl;
-    QGV::GeoRect rect = tilePos.toGeoRect();
-    url.replace("lonLeft", QString::number(rect.lonLeft(), 'f', 6));
-    url.replace("latBottom", QString::number(rect.latBottom(), 'f', 6));
-    url.replace("lonRight", QString::number(rect.lonRight(), 'f', 6));
-    url.replace("latTop", QString::number(rect.latTop(), 'f', 6));
-    double m_width = rect.lonRight() - rect.lonLeft();
-    double m_height = rect.latTop() - rect.latBottom();
-    double ratio = m_width / m_height;
-    int width_pixels = 900;
-    int height_pixels = (int)((double)width_pixels / ratio);
-    url.replace("WIDTH", QString::number(width_pixels));
-    url.replace("HEIGHT", QString::number(height_pixels));
-    return url;
-}
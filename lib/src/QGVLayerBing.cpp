@@ -47,6 +47,7 @@ QGVLayerBing::QGVLayerBing(QGV::TilesType type, QLocale locale, int serverNumber
     , mLocale(locale)
     , mServerNumber(serverNumber)
 {
+    compile();
     createName();
     setDescription("Copyrights ©Microsoft");
 }
@@ -54,12 +55,14 @@ QGVLayerBing::QGVLayerBing(QGV::TilesType type, QLocale locale, int serverNumber
 void QGVLayerBing::setType(QGV::TilesType type)
 {
     mType = type;
+    compile();
     createName();
 }
 
 void QGVLayerBing::setLocale(const QLocale& locale)
 {
     mLocale = locale;
+    compile();
     createName();
 }
 
@@ -97,9 +100,27 @@ int QGVLayerBing::maxZoomlevel() const
 
 QString QGVLayerBing::tilePosToUrl(const QGV::GeoTilePos& tilePos) const
 {
-    const QStringList& list = URLTemplates[mType];
-    QString url = list.value(mServerNumber).toLower();
-    url.replace("${lcl}", mLocale.name());
-    url.replace("${qk}", tilePos.toQuadKey());
-    return url;
+    return mTemplates.value(mServerNumber).format(values(tilePos));
+}
+
+QStringList QGVLayerBing::tilePosToMirrorUrls(const QGV::GeoTilePos& tilePos) const
+{
+    return formatUrls(mTemplates, values(tilePos));
+}
+
+QGVUrlTemplate::Values QGVLayerBing::values(const QGV::GeoTilePos& tilePos) const
+{
+    QGVUrlTemplate::Values result;
+    result.tilePos = tilePos;
+    result.locale = mLocaleName;
+    return result;
+}
+
+void QGVLayerBing::compile()
+{
+    mLocaleName = mLocale.name();
+    mTemplates.clear();
+    for (const QString& url : URLTemplates[mType]) {
+        mTemplates.append(QGVUrlTemplate(url.toLower()));
+    }
 }
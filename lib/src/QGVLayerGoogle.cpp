@@ -50,6 +50,7 @@ QGVLayerGoogle::QGVLayerGoogle(QGV::TilesType type, QLocale locale, int serverNu
     , mLocale(locale)
     , mServerNumber(serverNumber)
 {
+    compile();
     createName();
     setDescription("Copyrights ©Google");
 }
@@ -57,12 +58,14 @@ QGVLayerGoogle::QGVLayerGoogle(QGV::TilesType type, QLocale locale, int serverNu
 void QGVLayerGoogle::setType(QGV::TilesType type)
 {
     mType = type;
+    compile();
     createName();
 }
 
 void QGVLayerGoogle::setLocale(const QLocale& locale)
 {
     mLocale = locale;
+    compile();
     createName();
 }
 
@@ -100,11 +103,27 @@ int QGVLayerGoogle::maxZoomlevel() const
 
 QString QGVLayerGoogle::tilePosToUrl(const QGV::GeoTilePos& tilePos) const
 {
-    const QStringList& list = URLTemplates[mType];
-    QString url = list.value(mServerNumber).toLower();
-    url.replace("${lcl}", mLocale.name());
-    url.replace("${z}", QString::number(tilePos.zoom()));
-    url.replace("${x}", QString::number(tilePos.pos().x()));
-    url.replace("${y}", QString::number(tilePos.pos().y()));
-    return url;
+    return mTemplates.value(mServerNumber).format(values(tilePos));
+}
+
+QStringList QGVLayerGoogle::tilePosToMirrorUrls(const QGV::GeoTilePos& tilePos) const
+{
+    return formatUrls(mTemplates, values(tilePos));
+}
+
+QGVUrlTemplate::Values QGVLayerGoogle::values(const QGV::GeoTilePos& tilePos) const
+{
+    QGVUrlTemplate::Values result;
+    result.tilePos = tilePos;
+    result.locale = mLocaleName;
+    return result;
+}
+
+void QGVLayerGoogle::compile()
+{
+    mLocaleName = mLocale.name();
+    mTemplates.clear();
+    for (const QString& url : URLTemplates[mType]) {
+        mTemplates.append(QGVUrlTemplate(url.toLower()));
+    }
 }
@@ -32,14 +32,18 @@ const QStringList URLTemplates = {
 
 QGVLayerOSM::QGVLayerOSM(int serverNumber)
     : mUrl(URLTemplates.value(serverNumber))
+    , mMirrors(URLTemplates)
 {
+    compile();
     setName("OpenStreetMap");
     setDescription("Copyrights ©OpenStreetMap");
 }
 
 QGVLayerOSM::QGVLayerOSM(const QString& url)
     : mUrl(url)
+    , mMirrors(QStringList{ url })
 {
+    compile();
     setName("Custom");
     setDescription("OSM-like map");
 }
@@ -47,6 +51,8 @@ QGVLayerOSM::QGVLayerOSM(const QString& url)
 void QGVLayerOSM::setUrl(const QString& url)
 {
     mUrl = url;
+    mMirrors = QStringList{ url };
+    compile();
 }
 
 QString QGVLayerOSM::getUrl() const
@@ -54,6 +60,20 @@ QString QGVLayerOSM::getUrl() const
     return mUrl;
 }
 
+void QGVLayerOSM::setMirrorUrls(const QStringList& urls)
+{
+    mMirrors = urls;
+    if (!mMirrors.contains(mUrl)) {
+        mUrl = mMirrors.value(0);
+    }
+    compile();
+}
+
+QStringList QGVLayerOSM::getMirrorUrls() const
+{
+    return mMirrors;
+}
+
 int QGVLayerOSM::minZoomlevel() const
 {
     return 0;
@@ -66,9 +86,23 @@ int QGVLayerOSM::maxZoomlevel() const
 
 QString QGVLayerOSM::tilePosToUrl(const QGV::GeoTilePos& tilePos) const
 {
-    QString url = mUrl.toLower();
-    url.replace("${z}", QString::number(tilePos.zoom()));
-    url.replace("${x}", QString::number(tilePos.pos().x()));
-    url.replace("${y}", QString::number(tilePos.pos().y()));
-    return url;
+    QGVUrlTemplate::Values values;
+    values.tilePos = tilePos;
+    return mTemplate.format(values);
+}
+
+QStringList QGVLayerOSM::tilePosToMirrorUrls(const QGV::GeoTilePos& tilePos) const
+{
+    QGVUrlTemplate::Values values;
+    values.tilePos = tilePos;
+    return formatUrls(mMirrorTemplates, values);
+}
+
+void QGVLayerOSM::compile()
+{
+    mTemplate = QGVUrlTemplate(mUrl.toLower());
+    mMirrorTemplates.clear();
+    for (const QString& url : mMirrors) {
+        mMirrorTemplates.append(QGVUrlTemplate(url.toLower()));
+    }
 }
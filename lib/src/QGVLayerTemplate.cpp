@@ -0,0 +1,161 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVLayerTemplate.h"
+
+namespace {
+const double mercatorHalfSize = 20037508.342789244;
+}
+
+QGVLayerTemplate::QGVLayerTemplate(const QString& urlTemplate, QGV::TilesScheme scheme)
+    : mTemplate(urlTemplate)
+    , mScheme(scheme)
+    , mMinZoom(0)
+    , mMaxZoom(19)
+    , mTileSize(256, 256)
+    , mWmsCrs("EPSG:3857")
+{
+    setName("Template");
+    setDescription(urlTemplate);
+}
+
+void QGVLayerTemplate::setUrlTemplate(const QString& urlTemplate)
+{
+    mTemplate = QGVUrlTemplate(urlTemplate);
+}
+
+QString QGVLayerTemplate::getUrlTemplate() const
+{
+    return mTemplate.text();
+}
+
+void QGVLayerTemplate::setScheme(QGV::TilesScheme scheme)
+{
+    mScheme = scheme;
+}
+
+QGV::TilesScheme QGVLayerTemplate::getScheme() const
+{
+    return mScheme;
+}
+
+void QGVLayerTemplate::setSubdomains(const QStringList& subdomains)
+{
+    mSubdomains = subdomains;
+}
+
+QStringList QGVLayerTemplate::getSubdomains() const
+{
+    return mSubdomains;
+}
+
+void QGVLayerTemplate::setZoomRange(int minZoom, int maxZoom)
+{
+    mMinZoom = minZoom;
+    mMaxZoom = maxZoom;
+}
+
+void QGVLayerTemplate::setTileSize(const QSize& size)
+{
+    mTileSize = size;
+}
+
+QSize QGVLayerTemplate::getTileSize() const
+{
+    return mTileSize;
+}
+
+void QGVLayerTemplate::setTileMatrixSet(const QString& tileMatrixSet, const QStringList& tileMatrices)
+{
+    mTileMatrixSet = tileMatrixSet;
+    mTileMatrices = tileMatrices;
+}
+
+QString QGVLayerTemplate::getTileMatrixSet() const
+{
+    return mTileMatrixSet;
+}
+
+void QGVLayerTemplate::setWmsCrs(const QString& crs)
+{
+    mWmsCrs = crs;
+}
+
+QString QGVLayerTemplate::getWmsCrs() const
+{
+    return mWmsCrs;
+}
+
+int QGVLayerTemplate::minZoomlevel() const
+{
+    return mMinZoom;
+}
+
+int QGVLayerTemplate::maxZoomlevel() const
+{
+    return mMaxZoom;
+}
+
+QString QGVLayerTemplate::tilePosToUrl(const QGV::GeoTilePos& tilePos) const
+{
+    return mTemplate.format(values(tilePos));
+}
+
+QStringList QGVLayerTemplate::tilePosToMirrorUrls(const QGV::GeoTilePos& tilePos) const
+{
+    if (mSubdomains.size() < 2 || !mTemplate.has(QGVUrlTemplate::Field::Subdomain)) {
+        return { tilePosToUrl(tilePos) };
+    }
+    QGVUrlTemplate::Values tileValues = values(tilePos);
+    QStringList urls;
+    urls.reserve(mSubdomains.size());
+    for (const QString& subdomain : mSubdomains) {
+        tileValues.subdomain = subdomain;
+        urls.append(mTemplate.format(tileValues));
+    }
+    return urls;
+}
+
+QGVUrlTemplate::Values QGVLayerTemplate::values(const QGV::GeoTilePos& tilePos) const
+{
+    QGVUrlTemplate::Values result;
+    result.tilePos = tilePos;
+    result.flipY = (mScheme == QGV::TilesScheme::TMS);
+    result.subdomain = mSubdomains.value(0);
+    result.size = mTileSize;
+    if (mScheme == QGV::TilesScheme::WMTS) {
+        result.tileMatrixSet = mTileMatrixSet;
+        result.tileMatrices = mTileMatrices;
+    }
+    if (!mTemplate.has(QGVUrlTemplate::Field::BBox)) {
+        return result;
+    }
+    if (mWmsCrs.compare("EPSG:4326", Qt::CaseInsensitive) == 0 || mWmsCrs.compare("CRS:84", Qt::CaseInsensitive) == 0) {
+        // Geographic image keeps square pixels in degrees, height follows aspect of tile
+        const QGV::GeoRect rect = tilePos.toGeoRect();
+        result.bbox = QRectF(QPointF(rect.lonLeft(), rect.latBottom()), QPointF(rect.lonRight(), rect.latTop()));
+        const double ratio = result.bbox.width() / result.bbox.height();
+        result.size.setHeight(static_cast<int>(mTileSize.width() / ratio));
+    } else {
+        const double size = 2.0 * mercatorHalfSize / (1 << tilePos.zoom());
+        const double minX = -mercatorHalfSize + tilePos.pos().x() * size;
+        const double maxY = mercatorHalfSize - tilePos.pos().y() * size;
+        result.bbox = QRectF(QPointF(minX, maxY - size), QPointF(minX + size, maxY));
+    }
+    return result;
+}
@@ -18,15 +18,139 @@
 
 #include "QGVLayerTiles.h"
 #include "QGVDrawItem.h"
+#include "Raster/QGVImage.h"
 
+#include <QPainter>
+#include <QSet>
 #include <QtMath>
 
+#include <algorithm>
+
+/*!
+ * Single draw item which paints all composited tiles of layer, tiles are kept as textures and
+ * never enter QGraphicsScene by themselves.
+ */
+class QGVTilesCanvas : public QGVDrawItem
+{
+public:
+    void insert(const QGVDrawItem* tile, const QGV::GeoTilePos& tilePos, const QImage& image)
+    {
+        Texture texture;
+        texture.tilePos = tilePos;
+        texture.pixmap = QPixmap::fromImage(image);
+        texture.opacity = tile->getOpacity();
+        if (getMap() != nullptr) {
+            texture.projRect = getMap()->getProjection()->geoToProj(tilePos.toGeoRect());
+        }
+        mTextures.insert(tile, texture);
+        repaint();
+    }
+
+    void remove(const QGVDrawItem* tile)
+    {
+        if (mTextures.remove(tile) > 0) {
+            repaint();
+        }
+    }
+
+    QGraphicsItem::CacheMode projCacheMode() const override
+    {
+        return QGraphicsItem::NoCache;
+    }
+
+    QPainterPath projShape() const override
+    {
+        QPainterPath path;
+        if (getMap() != nullptr) {
+            path.addRect(getMap()->getProjection()->boundaryProjRect());
+        }
+        return path;
+    }
+
+    void projPaint(QPainter* painter) override
+    {
+        const QGVCameraState camera = getMap()->getCamera();
+        const QRectF viewRect = camera.projRect();
+        const double pixelFactor = 1.0 / camera.scale();
+        QVector<const Texture*> visible;
+        visible.reserve(mTextures.size());
+        for (const Texture& texture : mTextures) {
+            if (texture.projRect.intersects(viewRect)) {
+                visible.append(&texture);
+            }
+        }
+        std::sort(visible.begin(), visible.end(), [](const Texture* left, const Texture* right) {
+            return left->tilePos.zoom() < right->tilePos.zoom();
+        });
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        for (const Texture* texture : visible) {
+            QRectF paintRect = texture->projRect;
+            paintRect.setSize(paintRect.size() + QSizeF(pixelFactor, pixelFactor));
+            painter->setOpacity(texture->opacity);
+            painter->drawPixmap(paintRect, texture->pixmap, texture->pixmap.rect());
+        }
+    }
+
+    QString projDebug() override
+    {
+        return QString("tiles canvas\ntextures %1").arg(mTextures.size());
+    }
+
+protected:
+    void onProjection(QGVMap* geoMap) override
+    {
+        QGVDrawItem::onProjection(geoMap);
+        for (Texture& texture : mTextures) {
+            texture.projRect = geoMap->getProjection()->geoToProj(texture.tilePos.toGeoRect());
+        }
+        resetBoundary();
+    }
+
+private:
+    struct Texture
+    {
+        QGV::GeoTilePos tilePos;
+        QPixmap pixmap;
+        QRectF projRect;
+        double opacity = 1.0;
+    };
+    QHash<const QGVDrawItem*, Texture> mTextures;
+};
+
+namespace {
+const int coarseLevel = -1;
+const double arrivalSmoothing = 0.2;
+
+QPointF geoToTileCoords(int zoom, const QGV::GeoPos& geoPos)
+{
+    const double size = qPow(2.0, zoom);
+    const double lat = qDegreesToRadians(geoPos.latitude());
+    const double x = (geoPos.longitude() + 180.0) / 360.0 * size;
+    const double y = (1.0 - qLn(qTan(lat) + 1.0 / qCos(lat)) / M_PI) / 2.0 * size;
+    return QPointF(x, y);
+}
+}
+
 QGVLayerTiles::QGVLayerTiles()
+    : mCanvas(nullptr)
+    , mOwnCache(new QGVTilesCache())
+    , mCache(mOwnCache.data())
+    , mScheduler(this, [this]() { dispatchRequests(); })
+    , mDispatching(false)
+    , mCoarseZoom(-1)
+    , mArrivalIntervalMs(0)
+    , mArrivalBusy(false)
 {
     mCurZoom = -1;
     sendToBack();
 }
 
+QGVLayerTiles::~QGVLayerTiles()
+{
+    mCache->clear(this);
+    deleteDetachedTiles();
+}
+
 void QGVLayerTiles::setTilesMarginWithZoomChange(size_t value)
 {
     mPerfomanceProfile.TilesMarginWithZoomChange = value;
@@ -63,6 +187,89 @@ void QGVLayerTiles::setCameraUpdatesDuringAnimation(bool value)
     qgvDebug() << "CameraUpdatesDuringAnimation changed to" << value;
 }
 
+void QGVLayerTiles::setMaxRequestsInFlight(size_t value)
+{
+    mScheduler.setMaxRequestsInFlight(value);
+    qgvDebug() << "MaxRequestsInFlight changed to" << value;
+    dispatchRequests();
+}
+
+void QGVLayerTiles::setPrefetchTiles(bool value)
+{
+    mPerfomanceProfile.PrefetchTiles = value;
+    qgvDebug() << "PrefetchTiles changed to" << value;
+    if (!value) {
+        mScheduler.clearPrefetch();
+    }
+}
+
+void QGVLayerTiles::setPrefetchPanLeadMs(size_t value)
+{
+    mPerfomanceProfile.PrefetchPanLeadMs = value;
+    qgvDebug() << "PrefetchPanLeadMs changed to" << value;
+}
+
+void QGVLayerTiles::setFallbackTiles(bool value)
+{
+    mPerfomanceProfile.FallbackTiles = value;
+    qgvDebug() << "FallbackTiles changed to" << value;
+    if (!value) {
+        clearPlaceholders();
+    }
+}
+
+void QGVLayerTiles::setRenderMode(QGV::TilesRenderMode value)
+{
+    if (mPerfomanceProfile.RenderMode == value) {
+        return;
+    }
+    const auto tiles = shownTiles();
+    for (const auto& tile : tiles) {
+        hideTile(tile.second);
+    }
+    mPerfomanceProfile.RenderMode = value;
+    for (const auto& tile : tiles) {
+        showTile(tile.first, tile.second);
+    }
+    qgvDebug() << "RenderMode changed to" << static_cast<int>(value);
+}
+
+void QGVLayerTiles::setAdaptiveResolution(bool value)
+{
+    mPerfomanceProfile.AdaptiveResolution = value;
+    qgvDebug() << "AdaptiveResolution changed to" << value;
+}
+
+void QGVLayerTiles::setAdaptiveFullScreenMs(size_t value)
+{
+    mPerfomanceProfile.AdaptiveFullScreenMs = value;
+    qgvDebug() << "AdaptiveFullScreenMs changed to" << value;
+}
+
+void QGVLayerTiles::setAdaptiveMaxZoomDrop(size_t value)
+{
+    mPerfomanceProfile.AdaptiveMaxZoomDrop = value;
+    qgvDebug() << "AdaptiveMaxZoomDrop changed to" << value;
+}
+
+void QGVLayerTiles::setTilesCache(QGVTilesCache* cache)
+{
+    if (cache == nullptr) {
+        cache = mOwnCache.data();
+    }
+    if (mCache == cache) {
+        return;
+    }
+    mCache->clear(this);
+    mCache = cache;
+    qgvDebug() << "TilesCache changed to" << mCache->getMaxBytes() << "bytes";
+}
+
+QGVTilesCache* QGVLayerTiles::getTilesCache() const
+{
+    return mCache;
+}
+
 void QGVLayerTiles::onProjection(QGVMap* geoMap)
 {
     QGVLayer::onProjection(geoMap);
@@ -76,6 +283,8 @@ void QGVLayerTiles::onCamera(const QGVCameraState& oldState, const QGVCameraStat
         return;
     }
 
+    prefetchPan(oldState, newState);
+
     bool needUpdate = true;
 
     if (newState.animation()) {
@@ -97,6 +306,36 @@ void QGVLayerTiles::onCamera(const QGVCameraState& oldState, const QGVCameraStat
     }
 }
 
+void QGVLayerTiles::onPrefetch(const QList<QGVCameraState>& targetStates)
+{
+    QGVLayer::onPrefetch(targetStates);
+
+    if (!mPerfomanceProfile.PrefetchTiles || getMap() == nullptr || !isVisible()) {
+        return;
+    }
+    mScheduler.clearPrefetch();
+    int level = 0;
+    for (const QGVCameraState& target : targetStates) {
+        level++;
+        const int zoom = scaleToZoom(target.scale());
+        if (zoom < minZoomlevel() || zoom > maxZoomlevel()) {
+            continue;
+        }
+        const QRect rect = tilesRect(zoom, target.projRect());
+        qgvDebug() << "prefetch zoom" << zoom << "rect" << rect.topLeft() << rect.bottomRight();
+        for (int x = rect.left(); x <= rect.right(); ++x) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                const auto tilePos = QGV::GeoTilePos(zoom, QPoint(x, y));
+                if (isTileExists(tilePos) || mCache->contains(this, tilePos)) {
+                    continue;
+                }
+                mScheduler.enqueue(tilePos, requestHost(tilePos), level);
+            }
+        }
+    }
+    dispatchRequests();
+}
+
 void QGVLayerTiles::onUpdate()
 {
     QGVLayer::onUpdate();
@@ -108,16 +347,118 @@ void QGVLayerTiles::onClean()
     QGVLayer::onClean();
     mCurZoom = -1;
     mCurRect = {};
+    mCoarseZoom = -1;
+    mLastPan.invalidate();
+    mLastPanPrefetch = {};
+    deleteDetachedTiles();
     mIndex.clear();
+    mPlaceholders.clear();
+    mStale.clear();
+    mScheduler.clear();
+    mCanvas = nullptr;
     deleteItems();
 }
 
 void QGVLayerTiles::onTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
 {
-    if (tilePos.zoom() != mCurZoom || !mCurRect.contains(tilePos.pos())) {
+    mScheduler.finished(tilePos);
+    updateArrivalRate();
+    insertTile(tilePos, tileObj);
+    dispatchRequests();
+}
+
+void QGVLayerTiles::onTileFailed(const QGV::GeoTilePos& tilePos)
+{
+    qgvDebug() << "failed tile" << tilePos;
+    mScheduler.finished(tilePos);
+    mStale.remove(tilePos.toKey());
+    updateArrivalRate();
+    dispatchRequests();
+}
+
+QString QGVLayerTiles::requestHost(const QGV::GeoTilePos& /*tilePos*/) const
+{
+    return {};
+}
+
+QString QGVLayerTiles::requestedHost(const QGV::GeoTilePos& tilePos) const
+{
+    // Host given by requestHost() when tile was queued, request in flight is accounted to it
+    return mScheduler.inFlightHost(tilePos);
+}
+
+void QGVLayerTiles::reloadTiles()
+{
+    // Shown tiles of current zoom stay until new content replaces them, other tiles and cache are dropped
+    QVector<QGV::GeoTilePos> tiles;
+    for (int zoom = 0; zoom < mIndex.levels(); ++zoom) {
+        mIndex.keys(zoom, tiles);
+    }
+    for (const QGV::GeoTilePos& tilePos : tiles) {
+        const bool shown = isTileFinished(tilePos) && tilePos.zoom() == mCurZoom && mCurRect.contains(tilePos.pos());
+        if (!shown) {
+            removeTile(tilePos);
+            continue;
+        }
+        if (mStale.contains(tilePos.toKey())) {
+            // Request in flight was made for old content
+            abortRequest(tilePos);
+        } else {
+            mStale.insert(tilePos.toKey());
+        }
+        mScheduler.enqueue(tilePos, requestHost(tilePos));
+    }
+    clearPlaceholders();
+    mCache->clear(this);
+    qgvDebug() << "reload" << mStale.size() << "tiles";
+    processCamera();
+    // Camera may stay same, dropped pending and failed tiles of current view are queued again here
+    queueMissingTiles();
+}
+
+void QGVLayerTiles::retryFailedTiles()
+{
+    // Failed tiles keep empty entry in index, nothing else requests them until zoom changes
+    QVector<QGV::GeoTilePos> tiles;
+    for (int zoom = 0; zoom < mIndex.levels(); ++zoom) {
+        mIndex.keys(zoom, tiles);
+    }
+    int count = 0;
+    for (const QGV::GeoTilePos& tilePos : tiles) {
+        if (isTileFinished(tilePos) || mScheduler.isQueued(tilePos) || mScheduler.isInFlight(tilePos)) {
+            continue;
+        }
+        mScheduler.enqueue(tilePos, requestHost(tilePos), isCoarseTile(tilePos) ? coarseLevel : 0);
+        count++;
+    }
+    qgvDebug() << "retry" << count << "failed tiles";
+    dispatchRequests();
+}
+
+void QGVLayerTiles::refreshTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
+{
+    // Newer content for tile which is already loaded, pending requests deliver their own result
+    mCache->remove(this, tilePos);
+    if (!isTileFinished(tilePos) || mStale.contains(tilePos.toKey())) {
         delete tileObj;
         return;
     }
+    qgvDebug() << "refresh tile" << tilePos;
+    mStale.insert(tilePos.toKey());
+    addTile(tilePos, tileObj);
+}
+
+void QGVLayerTiles::insertTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
+{
+    if (isCoarseTile(tilePos)) {
+        addTile(tilePos, tileObj);
+        removeWhenCovered(tilePos);
+        return;
+    }
+    if (tilePos.zoom() != mCurZoom || !mCurRect.contains(tilePos.pos())) {
+        parkTile(tilePos, tileObj);
+        return;
+    }
     addTile(tilePos, tileObj);
 
     removeAllAbove(tilePos);
@@ -125,10 +466,9 @@ void QGVLayerTiles::onTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
     const int fromZoom = minZoomlevel();
     const int toZoom = tilePos.zoom() - 1;
     for (int zoom = fromZoom; zoom <= toZoom; ++zoom) {
-        for (const QGV::GeoTilePos& below : existingTiles(zoom)) {
-            if (below.contains(tilePos)) {
-                removeWhenCovered(below);
-            }
+        const QGV::GeoTilePos below = tilePos.parent(zoom);
+        if (isTileExists(below)) {
+            removeWhenCovered(below);
         }
     }
 }
@@ -148,7 +488,6 @@ void QGVLayerTiles::processCamera()
     const QGVProjection* projection = getMap()->getProjection();
     const QGVCameraState camera = getMap()->getCamera();
     const QRectF areaProjRect = camera.projRect().intersected(projection->boundaryProjRect());
-    const QGV::GeoRect areaGeoRect = projection->projToGeo(areaProjRect);
 
     int originZoom = scaleToZoom(camera.scale());
     int newZoom = qMin(maxZoomlevel(), qMax(minZoomlevel(), originZoom));
@@ -158,34 +497,50 @@ void QGVLayerTiles::processCamera()
 
     const bool zoomChanged = (mCurZoom != newZoom);
     mCurZoom = newZoom;
+    if (zoomChanged) {
+        mCoarseZoom = -1;
+    }
 
     const int margin = (zoomChanged) ? static_cast<int>(mPerfomanceProfile.TilesMarginWithZoomChange)
                                      : static_cast<int>(mPerfomanceProfile.TilesMarginNoZoomChange);
     const int sizePerZoom = static_cast<int>(qPow(2, mCurZoom));
     const QRect maxRect = QRect(QPoint(0, 0), QPoint(sizePerZoom, sizePerZoom));
-    const QPoint topLeft = QGV::GeoTilePos::geoToTilePos(mCurZoom, areaGeoRect.topLeft()).pos();
-    const QPoint bottomRight = QGV::GeoTilePos::geoToTilePos(mCurZoom, areaGeoRect.bottomRight()).pos();
-    QRect activeRect = QRect(topLeft, bottomRight);
+    QRect activeRect = tilesRect(mCurZoom, camera.projRect());
     activeRect = activeRect.adjusted(-margin, -margin, margin, margin);
     activeRect = activeRect.intersected(maxRect);
     const bool rectChanged = (!zoomChanged && (mCurRect != activeRect));
     mCurRect = activeRect;
+    mScheduler.setView(mCurZoom, geoToTileCoords(mCurZoom, projection->projToGeo(areaProjRect.center())));
 
     if (!zoomChanged && !rectChanged) {
         return;
     }
 
+    QVector<QGV::GeoTilePos> tiles;
+
     if (zoomChanged) {
         qgvDebug() << "new active zoom" << mCurZoom;
+        clearPlaceholders();
         const int fromZoom = minZoomlevel();
         const int toZoom = maxZoomlevel();
         for (int zoom = fromZoom; zoom <= toZoom; ++zoom) {
-            if (zoom == mCurZoom) {
-                for (const QGV::GeoTilePos& current : existingTiles(zoom)) {
+            tiles.clear();
+            mIndex.keys(zoom, tiles);
+            if (mPerfomanceProfile.FallbackTiles) {
+                for (const QGV::GeoTilePos& tilePos : tiles) {
+                    if (zoom != mCurZoom || !mCurRect.contains(tilePos.pos())) {
+                        removeTile(tilePos);
+                    }
+                }
+            } else if (zoom == mCurZoom) {
+                for (const QGV::GeoTilePos& current : tiles) {
                     removeAllAbove(current);
                 }
             } else {
-                for (const QGV::GeoTilePos& nonCurrent : existingTiles(zoom)) {
+                for (const QGV::GeoTilePos& nonCurrent : tiles) {
+                    if (!isTileExists(nonCurrent)) {
+                        continue;
+                    }
                     if (!isTileFinished(nonCurrent)) {
                         qgvDebug() << "cancel non-finished" << nonCurrent;
                         removeTile(nonCurrent);
@@ -200,14 +555,28 @@ void QGVLayerTiles::processCamera()
 
     if (rectChanged) {
         qgvDebug() << "new active rect" << mCurRect.topLeft() << mCurRect.bottomRight();
-        for (const QGV::GeoTilePos& tilePos : existingTiles(mCurZoom)) {
+        tiles.clear();
+        const QGVTilesPyramid::Level& current = mIndex.level(mCurZoom);
+        for (auto it = current.constBegin(); it != current.constEnd(); ++it) {
+            const QGV::GeoTilePos tilePos = QGV::GeoTilePos::fromKey(it.key());
             if (!mCurRect.contains(tilePos.pos())) {
-                qgvDebug() << "delete out of boundary view" << tilePos;
-                removeTile(tilePos);
+                tiles.append(tilePos);
             }
         }
+        for (const QGV::GeoTilePos& tilePos : tiles) {
+            qgvDebug() << "delete out of boundary view" << tilePos;
+            removeTile(tilePos);
+        }
     }
 
+    queueMissingTiles();
+}
+
+void QGVLayerTiles::queueMissingTiles()
+{
+    if (getMap() == nullptr || !isVisible() || mCurZoom < minZoomlevel() || mCurZoom > maxZoomlevel()) {
+        return;
+    }
     QMultiMap<qreal, QGV::GeoTilePos> missing;
     for (int x = mCurRect.left(); x < mCurRect.right(); ++x) {
         for (int y = mCurRect.top(); y < mCurRect.bottom(); ++y) {
@@ -220,20 +589,156 @@ void QGVLayerTiles::processCamera()
         }
     }
 
+    QVector<QGV::GeoTilePos> pending;
     for (const QGV::GeoTilePos& tilePos : missing) {
-        addTile(tilePos, nullptr);
+        QGVDrawItem* cached = mCache->take(this, tilePos);
+        if (cached != nullptr) {
+            qgvDebug() << "revive tile" << tilePos;
+            insertTile(tilePos, cached);
+        } else {
+            addTile(tilePos, nullptr);
+            pending.append(tilePos);
+            if (mPerfomanceProfile.FallbackTiles) {
+                addPlaceholder(tilePos);
+            }
+        }
     }
+    if (mPerfomanceProfile.AdaptiveResolution) {
+        requestCoarse(pending);
+    }
+    dispatchRequests();
+}
+
+void QGVLayerTiles::requestCoarse(const QVector<QGV::GeoTilePos>& pending)
+{
+    if (pending.isEmpty() || mArrivalIntervalMs <= 0) {
+        return;
+    }
+    const double budget = static_cast<double>(mPerfomanceProfile.AdaptiveFullScreenMs);
+    const int backlog = mScheduler.queuedCount() + mScheduler.inFlightCount();
+    if (backlog * mArrivalIntervalMs <= budget) {
+        return;
+    }
+    // Smallest zoom drop which fills the view in time, tiles of coarse level go before current ones
+    const int maxDrop = qMin(static_cast<int>(mPerfomanceProfile.AdaptiveMaxZoomDrop), mCurZoom - minZoomlevel());
+    QSet<quint64> coarse;
+    for (int drop = 1; drop <= maxDrop; ++drop) {
+        coarse.clear();
+        for (const QGV::GeoTilePos& tilePos : pending) {
+            const QGV::GeoTilePos parent = tilePos.parent(mCurZoom - drop);
+            if (!isTileExists(parent)) {
+                coarse.insert(parent.toKey());
+            }
+        }
+        mCoarseZoom = mCurZoom - drop;
+        if (coarse.size() * mArrivalIntervalMs <= budget) {
+            break;
+        }
+    }
+    if (coarse.isEmpty()) {
+        return;
+    }
+    qgvDebug() << "adaptive zoom" << mCoarseZoom << "for" << coarse.size() << "tiles, backlog" << backlog;
+    for (quint64 key : coarse) {
+        const QGV::GeoTilePos tilePos = QGV::GeoTilePos::fromKey(key);
+        QGVDrawItem* cached = mCache->take(this, tilePos);
+        if (cached != nullptr) {
+            addTile(tilePos, cached);
+            continue;
+        }
+        mIndex.insert(tilePos, nullptr);
+        mScheduler.enqueue(tilePos, requestHost(tilePos), coarseLevel);
+    }
+}
+
+void QGVLayerTiles::updateArrivalRate()
+{
+    // Interval between tiles is measured only while layer was waiting for them
+    const bool wasBusy = mArrivalBusy && mLastArrival.isValid();
+    const qint64 elapsed = mLastArrival.isValid() ? mLastArrival.restart() : 0;
+    if (!mLastArrival.isValid()) {
+        mLastArrival.start();
+    }
+    mArrivalBusy = mScheduler.inFlightCount() > 0;
+    if (!wasBusy) {
+        return;
+    }
+    const double interval = static_cast<double>(qMax<qint64>(elapsed, 1));
+    if (mArrivalIntervalMs <= 0) {
+        mArrivalIntervalMs = interval;
+    } else {
+        mArrivalIntervalMs += arrivalSmoothing * (interval - mArrivalIntervalMs);
+    }
+}
+
+bool QGVLayerTiles::isCoarseTile(const QGV::GeoTilePos& tilePos) const
+{
+    return mCoarseZoom >= 0 && tilePos.zoom() == mCoarseZoom && isTileExists(tilePos) && !isTileFinished(tilePos);
+}
+
+void QGVLayerTiles::prefetchPan(const QGVCameraState& oldState, const QGVCameraState& newState)
+{
+    const bool panOnly = !newState.animation() && oldState.scale() == newState.scale() &&
+                         oldState.azimuth() == newState.azimuth();
+    if (!panOnly || !mPerfomanceProfile.PrefetchTiles || mPerfomanceProfile.PrefetchPanLeadMs == 0) {
+        mLastPan.invalidate();
+        return;
+    }
+    if (!mLastPan.isValid()) {
+        mLastPan.start();
+        return;
+    }
+    const qint64 elapsed = mLastPan.restart();
+    if (elapsed <= 0 || elapsed > static_cast<qint64>(mPerfomanceProfile.PrefetchPanLeadMs)) {
+        return;
+    }
+    const QPointF velocity = (newState.projCenter() - oldState.projCenter()) / static_cast<double>(elapsed);
+    const QPointF shift = velocity * static_cast<double>(mPerfomanceProfile.PrefetchPanLeadMs);
+    const QRectF projRect = newState.projRect().translated(shift);
+    const int zoom = scaleToZoom(newState.scale());
+    const QRect rect = tilesRect(zoom, projRect);
+    if (rect == mLastPanPrefetch) {
+        return;
+    }
+    mLastPanPrefetch = rect;
+    onPrefetch({ QGVCameraState(getMap(), newState.azimuth(), newState.scale(), projRect, false) });
+}
+
+QRect QGVLayerTiles::tilesRect(int zoom, const QRectF& projRect) const
+{
+    const QGVProjection* projection = getMap()->getProjection();
+    const QRectF areaProjRect = projRect.intersected(projection->boundaryProjRect());
+    const QGV::GeoRect areaGeoRect = projection->projToGeo(areaProjRect);
+    const int sizePerZoom = static_cast<int>(qPow(2, zoom));
+    const QRect maxRect = QRect(QPoint(0, 0), QPoint(sizePerZoom, sizePerZoom));
+    const QPoint topLeft = QGV::GeoTilePos::geoToTilePos(zoom, areaGeoRect.topLeft()).pos();
+    const QPoint bottomRight = QGV::GeoTilePos::geoToTilePos(zoom, areaGeoRect.bottomRight()).pos();
+    return QRect(topLeft, bottomRight).intersected(maxRect);
+}
+
+void QGVLayerTiles::dispatchRequests()
+{
+    if (mDispatching) {
+        return;
+    }
+    mDispatching = true;
+    QGV::GeoTilePos tilePos;
+    while (mScheduler.takeNext(tilePos)) {
+        qgvDebug() << "request tile" << tilePos;
+        request(tilePos);
+    }
+    mDispatching = false;
 }
 
 void QGVLayerTiles::removeAllAbove(const QGV::GeoTilePos& tilePos)
 {
     const int fromZoom = tilePos.zoom() + 1;
     const int toZoom = maxZoomlevel();
+    QVector<QGV::GeoTilePos> above;
     for (int zoom = fromZoom; zoom <= toZoom; ++zoom) {
-        for (const QGV::GeoTilePos& target : existingTiles(zoom)) {
-            if (!tilePos.contains(target)) {
-                continue;
-            }
+        above.clear();
+        mIndex.findDescendants(tilePos, zoom, above);
+        for (const QGV::GeoTilePos& target : above) {
             qgvDebug() << "remove" << target << "above" << tilePos;
             removeTile(target);
         }
@@ -245,10 +750,9 @@ void QGVLayerTiles::removeWhenCovered(const QGV::GeoTilePos& tilePos)
     const int zoomDelta = mCurZoom - tilePos.zoom() + 1;
     const int neededCount = static_cast<int>(qPow(2, zoomDelta));
     int count = neededCount;
-    for (const QGV::GeoTilePos& current : existingTiles(mCurZoom)) {
-        if (!tilePos.contains(current)) {
-            continue;
-        }
+    QVector<QGV::GeoTilePos> covering;
+    mIndex.findDescendants(tilePos, mCurZoom, covering);
+    for (const QGV::GeoTilePos& current : covering) {
         if (!isTileFinished(current)) {
             break;
         }
@@ -279,47 +783,230 @@ void QGVLayerTiles::removeForPerfomance(const QGV::GeoTilePos& tilePos)
 void QGVLayerTiles::addTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
 {
     if (isTileFinished(tilePos)) {
-        delete tileObj;
-        return;
+        if (tileObj == nullptr || !mStale.remove(tilePos.toKey())) {
+            delete tileObj;
+            return;
+        }
+        QGVDrawItem* staleTile = mIndex.take(tilePos);
+        hideTile(staleTile);
+        delete staleTile;
     }
     if (tileObj == nullptr) {
-        qgvDebug() << "request tile" << tilePos;
-        mIndex[tilePos.zoom()][tilePos] = nullptr;
-        request(tilePos);
+        qgvDebug() << "queue tile" << tilePos;
+        mIndex.insert(tilePos, nullptr);
+        mScheduler.enqueue(tilePos, requestHost(tilePos));
     } else {
         qgvDebug() << "add tile" << tilePos;
-        mIndex[tilePos.zoom()][tilePos] = tileObj;
+        removePlaceholder(tilePos);
+        mIndex.insert(tilePos, tileObj);
         tileObj->setZValue(static_cast<qint16>(tilePos.zoom()));
-        addItem(tileObj);
+        showTile(tilePos, tileObj);
     }
 }
 
 void QGVLayerTiles::removeTile(const QGV::GeoTilePos& tilePos)
 {
-    const auto tile = mIndex[tilePos.zoom()].take(tilePos);
+    if (!isTileExists(tilePos)) {
+        return;
+    }
+    removePlaceholder(tilePos);
+    const auto tile = mIndex.take(tilePos);
+    if (mStale.remove(tilePos.toKey())) {
+        abortRequest(tilePos);
+        hideTile(tile);
+        delete tile;
+        return;
+    }
     if (tile == nullptr) {
-        qgvDebug() << "cancel tile" << tilePos;
-        cancel(tilePos);
+        abortRequest(tilePos);
     } else {
         qgvDebug() << "remove tile" << tilePos;
-        delete tile;
+        hideTile(tile);
+        parkTile(tilePos, tile);
     }
 }
 
-bool QGVLayerTiles::isTileExists(const QGV::GeoTilePos& tilePos) const
+void QGVLayerTiles::abortRequest(const QGV::GeoTilePos& tilePos)
 {
-    return mIndex[tilePos.zoom()].contains(tilePos);
+    if (!mScheduler.dequeue(tilePos)) {
+        qgvDebug() << "cancel tile" << tilePos;
+        mScheduler.finished(tilePos);
+        cancel(tilePos);
+    }
 }
 
-bool QGVLayerTiles::isTileFinished(const QGV::GeoTilePos& tilePos) const
+void QGVLayerTiles::parkTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
 {
-    if (!isTileExists(tilePos)) {
-        return false;
+    if (tileObj == nullptr) {
+        return;
+    }
+    if (tileObj->getParent() != nullptr) {
+        delete tileObj;
+        return;
+    }
+    // Cache cost counts only image, parked tile must not hold its paint copies
+    auto image = qobject_cast<QGVImage*>(tileObj);
+    if (image != nullptr) {
+        image->releasePixmaps();
+    }
+    mCache->insert(this, tilePos, tileObj);
+}
+
+void QGVLayerTiles::addPlaceholder(const QGV::GeoTilePos& tilePos)
+{
+    if (mPlaceholders.contains(tilePos.toKey())) {
+        return;
+    }
+    const QImage image = placeholderImage(tilePos);
+    if (image.isNull()) {
+        return;
+    }
+    auto placeholder = new QGVImage();
+    placeholder->setGeometry(tilePos.toGeoRect());
+    placeholder->loadImage(image);
+    placeholder->setZValue(static_cast<qint16>(tilePos.zoom()));
+    placeholder->setProperty("drawDebug",
+                             QString("placeholder(%1,%2,%3)")
+                                     .arg(tilePos.zoom())
+                                     .arg(tilePos.pos().x())
+                                     .arg(tilePos.pos().y()));
+    mPlaceholders.insert(tilePos.toKey(), placeholder);
+    showTile(tilePos, placeholder);
+}
+
+void QGVLayerTiles::removePlaceholder(const QGV::GeoTilePos& tilePos)
+{
+    QGVDrawItem* placeholder = mPlaceholders.take(tilePos.toKey());
+    if (placeholder != nullptr) {
+        hideTile(placeholder);
+        delete placeholder;
     }
-    return mIndex[tilePos.zoom()][tilePos] != nullptr;
 }
 
-QList<QGV::GeoTilePos> QGVLayerTiles::existingTiles(int zoom) const
+void QGVLayerTiles::clearPlaceholders()
+{
+    for (QGVDrawItem* placeholder : mPlaceholders) {
+        hideTile(placeholder);
+        delete placeholder;
+    }
+    mPlaceholders.clear();
+}
+
+void QGVLayerTiles::showTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
+{
+    const auto image = qobject_cast<QGVImage*>(tileObj);
+    if (mPerfomanceProfile.RenderMode != QGV::TilesRenderMode::Composite || image == nullptr) {
+        addItem(tileObj);
+        return;
+    }
+    if (mCanvas == nullptr) {
+        mCanvas = new QGVTilesCanvas();
+        mCanvas->setSelectable(false);
+        addItem(mCanvas);
+    }
+    mCanvas->insert(tileObj, tilePos, image->getImage());
+}
+
+void QGVLayerTiles::hideTile(QGVDrawItem* tileObj)
+{
+    if (tileObj->getParent() == this) {
+        removeItem(tileObj);
+    } else if (mCanvas != nullptr) {
+        mCanvas->remove(tileObj);
+    }
+}
+
+QList<QPair<QGV::GeoTilePos, QGVDrawItem*>> QGVLayerTiles::shownTiles() const
+{
+    QList<QPair<QGV::GeoTilePos, QGVDrawItem*>> result;
+    for (int zoom = 0; zoom < mIndex.levels(); ++zoom) {
+        const QGVTilesPyramid::Level& level = mIndex.level(zoom);
+        for (auto it = level.constBegin(); it != level.constEnd(); ++it) {
+            if (it.value() != nullptr) {
+                result.append(qMakePair(QGV::GeoTilePos::fromKey(it.key()), it.value()));
+            }
+        }
+    }
+    for (auto it = mPlaceholders.constBegin(); it != mPlaceholders.constEnd(); ++it) {
+        result.append(qMakePair(QGV::GeoTilePos::fromKey(it.key()), it.value()));
+    }
+    return result;
+}
+
+void QGVLayerTiles::deleteDetachedTiles()
+{
+    // Composited tiles are not children of layer and will not be deleted by deleteItems()
+    for (const auto& tile : shownTiles()) {
+        if (tile.second->getParent() == nullptr) {
+            delete tile.second;
+        }
+    }
+}
+
+QImage QGVLayerTiles::placeholderImage(const QGV::GeoTilePos& tilePos) const
+{
+    const int maxDelta = static_cast<int>(mPerfomanceProfile.FallbackMaxZoomDelta);
+    const int fromZoom = qMax(minZoomlevel(), tilePos.zoom() - maxDelta);
+    for (int zoom = tilePos.zoom() - 1; zoom >= fromZoom; --zoom) {
+        const QGV::GeoTilePos ancestor = tilePos.parent(zoom);
+        const QImage image = tileImage(ancestor);
+        if (image.isNull()) {
+            continue;
+        }
+        const int factor = 1 << (tilePos.zoom() - zoom);
+        const QSize size(image.width() / factor, image.height() / factor);
+        if (size.isEmpty()) {
+            break;
+        }
+        const QPoint offset((tilePos.pos().x() % factor) * size.width(), (tilePos.pos().y() % factor) * size.height());
+        return image.copy(QRect(offset, size));
+    }
+
+    if (tilePos.zoom() >= maxZoomlevel()) {
+        return {};
+    }
+    QImage result;
+    QPainter painter;
+    for (int i = 0; i < 4; ++i) {
+        const QPoint childPos(tilePos.pos().x() * 2 + (i % 2), tilePos.pos().y() * 2 + (i / 2));
+        const QImage image = tileImage(QGV::GeoTilePos(tilePos.zoom() + 1, childPos));
+        if (image.isNull()) {
+            continue;
+        }
+        if (result.isNull()) {
+            result = QImage(image.size(), QImage::Format_ARGB32_Premultiplied);
+            result.fill(Qt::transparent);
+            painter.begin(&result);
+            painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        }
+        const QSize quarter = result.size() / 2;
+        painter.drawImage(QRect(QPoint((i % 2) * quarter.width(), (i / 2) * quarter.height()), quarter), image);
+    }
+    if (painter.isActive()) {
+        painter.end();
+    }
+    return result;
+}
+
+QImage QGVLayerTiles::tileImage(const QGV::GeoTilePos& tilePos) const
+{
+    const QGVDrawItem* tile = mIndex.value(tilePos);
+    if (tile == nullptr) {
+        tile = mCache->find(this, tilePos);
+    }
+    const auto image = qobject_cast<const QGVImage*>(tile);
+    if (image == nullptr) {
+        return {};
+    }
+    return image->getImage();
+}
+
+bool QGVLayerTiles::isTileExists(const QGV::GeoTilePos& tilePos) const
+{
+    return mIndex.contains(tilePos);
+}
+
+bool QGVLayerTiles::isTileFinished(const QGV::GeoTilePos& tilePos) const
 {
-    return mIndex[zoom].keys();
+    return mIndex.value(tilePos) != nullptr;
 }
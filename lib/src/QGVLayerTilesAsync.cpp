@@ -0,0 +1,90 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVLayerTilesAsync.h"
+#include "Raster/QGVImage.h"
+
+QGVLayerTilesAsync::QGVLayerTilesAsync()
+{
+}
+
+QGVLayerTilesAsync::~QGVLayerTilesAsync()
+{
+    for (const auto& canceled : mJobs) {
+        canceled->storeRelease(1);
+    }
+}
+
+QGVDrawItem* QGVLayerTilesAsync::createTile(const QGV::GeoTilePos& tilePos, const QImage& image) const
+{
+    auto tile = new QGVImage();
+    tile->setGeometry(tilePos.toGeoRect());
+    tile->loadImage(image);
+    tile->setProperty("drawDebug",
+                      QString("%1\ntile(%2,%3,%4)")
+                              .arg(getName())
+                              .arg(tilePos.zoom())
+                              .arg(tilePos.pos().x())
+                              .arg(tilePos.pos().y()));
+    return tile;
+}
+
+void QGVLayerTilesAsync::request(const QGV::GeoTilePos& tilePos)
+{
+    const QGVTilesDecoder::Job job = tileJob(tilePos);
+    if (!job) {
+        onTileFailed(tilePos);
+        return;
+    }
+    const QSharedPointer<QAtomicInt> canceled(new QAtomicInt(0));
+    mJobs[tilePos] = canceled;
+    QGVTilesDecoder::globalDecoder()->run(
+            [job, canceled]() {
+                if (canceled->loadAcquire() != 0) {
+                    return QImage();
+                }
+                return job();
+            },
+            this,
+            [this, tilePos, canceled](const QImage& image) { onJobFinished(tilePos, canceled, image); });
+    qgvDebug() << "request" << tilePos;
+}
+
+void QGVLayerTilesAsync::cancel(const QGV::GeoTilePos& tilePos)
+{
+    const auto canceled = mJobs.take(tilePos);
+    if (!canceled.isNull()) {
+        canceled->storeRelease(1);
+    }
+}
+
+void QGVLayerTilesAsync::onJobFinished(const QGV::GeoTilePos& tilePos,
+                                       const QSharedPointer<QAtomicInt>& canceled,
+                                       const QImage& image)
+{
+    if (canceled->loadAcquire() != 0 || mJobs.value(tilePos) != canceled) {
+        qgvDebug() << "drop canceled" << tilePos;
+        return;
+    }
+    mJobs.remove(tilePos);
+    if (image.isNull()) {
+        onTileFailed(tilePos);
+        return;
+    }
+    onTile(tilePos, createTile(tilePos, image));
+}
@@ -0,0 +1,232 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVLayerTilesOffline.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#ifdef QGV_MBTILES
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#endif
+
+namespace {
+const int defaultMinZoom = 0;
+const int defaultMaxZoom = 20;
+
+#ifdef QGV_MBTILES
+QSqlDatabase mbtilesDatabase(const QString& path)
+{
+    // Connections can't be shared between threads, each worker keeps its own read-only connection
+    // until it exits (idle pool threads expire), so ids of new threads never meet stale connections
+    const QString name = QString("qgv-mbtiles-%1-%2")
+                                 .arg(qHash(path))
+                                 .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    if (QSqlDatabase::contains(name)) {
+        return QSqlDatabase::database(name);
+    }
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+    db.setDatabaseName(path);
+    db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    if (!db.open()) {
+        qgvCritical() << "unable to open mbtiles" << path << db.lastError().text();
+    }
+    QObject::connect(QThread::currentThread(), &QThread::finished, [name]() { QSqlDatabase::removeDatabase(name); });
+    return db;
+}
+#endif
+}
+
+QGVLayerTilesOffline::QGVLayerTilesOffline(const QString& path)
+    : mPath(path)
+    , mMBTiles(QFileInfo(path).isFile())
+    , mValid(false)
+    , mMinZoom(defaultMinZoom)
+    , mMaxZoom(defaultMaxZoom)
+{
+    setName("Offline");
+    setDescription(path);
+    if (mMBTiles) {
+        openMBTiles();
+    } else {
+        openDirectory();
+    }
+}
+
+QString QGVLayerTilesOffline::getPath() const
+{
+    return mPath;
+}
+
+bool QGVLayerTilesOffline::isMBTiles() const
+{
+    return mMBTiles;
+}
+
+bool QGVLayerTilesOffline::isValid() const
+{
+    return mValid;
+}
+
+void QGVLayerTilesOffline::setPathTemplate(const QString& pathTemplate)
+{
+    mPathTemplate = pathTemplate;
+}
+
+QString QGVLayerTilesOffline::getPathTemplate() const
+{
+    return mPathTemplate;
+}
+
+void QGVLayerTilesOffline::setZoomLevels(int minZoom, int maxZoom)
+{
+    mMinZoom = qMax(0, qMin(minZoom, maxZoom));
+    mMaxZoom = qMax(minZoom, maxZoom);
+}
+
+int QGVLayerTilesOffline::minZoomlevel() const
+{
+    return mMinZoom;
+}
+
+int QGVLayerTilesOffline::maxZoomlevel() const
+{
+    return mMaxZoom;
+}
+
+QGVTilesDecoder::Job QGVLayerTilesOffline::tileJob(const QGV::GeoTilePos& tilePos) const
+{
+    if (!mValid) {
+        return {};
+    }
+    if (mMBTiles) {
+        const QString path = mPath;
+        return [path, tilePos]() { return QGVTilesDecoder::decodeImage(readMBTile(path, tilePos)); };
+    }
+    QString fileName = mPathTemplate;
+    fileName.replace("${z}", QString::number(tilePos.zoom()));
+    fileName.replace("${x}", QString::number(tilePos.pos().x()));
+    fileName.replace("${y}", QString::number(tilePos.pos().y()));
+    const QString filePath = QDir(mPath).filePath(fileName);
+    return [filePath]() {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QImage();
+        }
+        return QGVTilesDecoder::decodeImage(file.readAll());
+    };
+}
+
+void QGVLayerTilesOffline::openMBTiles()
+{
+#ifdef QGV_MBTILES
+    QSqlDatabase db = mbtilesDatabase(mPath);
+    if (!db.isOpen()) {
+        return;
+    }
+    QSqlQuery query(db);
+    bool zoomFound = false;
+    if (query.exec("SELECT name, value FROM metadata")) {
+        while (query.next()) {
+            const QString name = query.value(0).toString();
+            const QString value = query.value(1).toString();
+            if (name == "minzoom") {
+                mMinZoom = value.toInt();
+                zoomFound = true;
+            } else if (name == "maxzoom") {
+                mMaxZoom = value.toInt();
+                zoomFound = true;
+            } else if (name == "name") {
+                setName(value);
+            }
+        }
+    }
+    if (!zoomFound && query.exec("SELECT MIN(zoom_level), MAX(zoom_level) FROM tiles") && query.next()) {
+        mMinZoom = query.value(0).toInt();
+        mMaxZoom = query.value(1).toInt();
+    }
+    mValid = true;
+    qgvDebug() << "mbtiles" << mPath << "zoom" << mMinZoom << mMaxZoom;
+#else
+    qgvCritical() << "mbtiles is not supported (QGeoView built without Qt Sql)" << mPath;
+#endif
+}
+
+void QGVLayerTilesOffline::openDirectory()
+{
+    mPathTemplate = "${z}/${x}/${y}.png";
+    const QDir root(mPath);
+    if (!root.exists()) {
+        qgvCritical() << "tiles directory not found" << mPath;
+        return;
+    }
+    QList<int> zooms;
+    for (const QString& name : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        bool ok = false;
+        const int zoom = name.toInt(&ok);
+        if (ok) {
+            zooms.append(zoom);
+        }
+    }
+    if (!zooms.isEmpty()) {
+        std::sort(zooms.begin(), zooms.end());
+        mMinZoom = zooms.first();
+        mMaxZoom = zooms.last();
+        const QDir zoomDir(root.filePath(QString::number(mMinZoom)));
+        const QStringList columns = zoomDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        if (!columns.isEmpty()) {
+            const QStringList files = QDir(zoomDir.filePath(columns.first())).entryList(QDir::Files);
+            if (!files.isEmpty()) {
+                mPathTemplate = "${z}/${x}/${y}." + QFileInfo(files.first()).suffix();
+            }
+        }
+    }
+    mValid = true;
+    qgvDebug() << "tiles directory" << mPath << mPathTemplate << "zoom" << mMinZoom << mMaxZoom;
+}
+
+QByteArray QGVLayerTilesOffline::readMBTile(const QString& path, const QGV::GeoTilePos& tilePos)
+{
+#ifdef QGV_MBTILES
+    QSqlDatabase db = mbtilesDatabase(path);
+    if (!db.isOpen()) {
+        return {};
+    }
+    // MBTiles rows are in TMS order (origin at bottom)
+    const int row = (1 << tilePos.zoom()) - 1 - tilePos.pos().y();
+    QSqlQuery query(db);
+    query.prepare("SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?");
+    query.addBindValue(tilePos.zoom());
+    query.addBindValue(tilePos.pos().x());
+    query.addBindValue(row);
+    if (!query.exec() || !query.next()) {
+        return {};
+    }
+    return query.value(0).toByteArray();
+#else
+    Q_UNUSED(path);
+    Q_UNUSED(tilePos);
+    return {};
+#endif
+}
@@ -19,73 +19,217 @@
 #include "QGVLayerTilesOnline.h"
 #include "Raster/QGVImage.h"
 
+#include <QtMath>
+
+namespace {
+quint64 mixKey(quint64 value)
+{
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+quint64 hostHash(const QString& host)
+{
+    quint64 hash = 0xcbf29ce484222325ULL;
+    for (const QChar symbol : host) {
+        hash = (hash ^ symbol.unicode()) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+QString urlHost(const QString& url)
+{
+    // Cheaper than QUrl parsing, url is produced by layer itself
+    const int scheme = url.indexOf(QLatin1String("://"));
+    const int begin = (scheme < 0) ? 0 : scheme + 3;
+    int end = begin;
+    while (end < url.size()) {
+        const QChar symbol = url.at(end);
+        if (symbol == '/' || symbol == ':' || symbol == '?' || symbol == '#') {
+            break;
+        }
+        end++;
+    }
+    return url.mid(begin, end - begin).toLower();
+}
+
+double rendezvousScore(quint64 tileKey, const QString& host, double weight)
+{
+    const quint64 hash = mixKey(tileKey ^ hostHash(host));
+    const double unit = (static_cast<double>(hash >> 11) + 0.5) / static_cast<double>(1ULL << 53);
+    return -weight / std::log(unit);
+}
+}
+
+QGVLayerTilesOnline::QGVLayerTilesOnline()
+    : mLoadBalancing(true)
+{
+    connect(QGVTilesFetcher::globalFetcher(),
+            &QGVTilesFetcher::tileRefreshed,
+            this,
+            &QGVLayerTilesOnline::onTileRefreshed);
+    connect(QGVTilesFetcher::globalFetcher(),
+            &QGVTilesFetcher::circuitClosed,
+            this,
+            &QGVLayerTilesOnline::onCircuitClosed);
+}
+
 QGVLayerTilesOnline::~QGVLayerTilesOnline()
 {
-    qDeleteAll(mRequest);
+    for (quint64 ticket : mTickets) {
+        QGVTilesFetcher::globalFetcher()->cancel(ticket);
+    }
 }
 
-void QGVLayerTilesOnline::request(const QGV::GeoTilePos& tilePos)
+void QGVLayerTilesOnline::setTilesStoreId(const QString& id)
 {
-    Q_ASSERT(QGV::getNetworkManager());
+    mStoreId = id;
+}
 
-    const QUrl url(tilePosToUrl(tilePos));
+void QGVLayerTilesOnline::setLoadBalancing(bool enabled)
+{
+    mLoadBalancing = enabled;
+    qgvDebug() << "LoadBalancing changed to" << enabled;
+}
 
-    QNetworkRequest request(url);
-    QSslConfiguration conf = request.sslConfiguration();
-    conf.setPeerVerifyMode(QSslSocket::VerifyNone);
+bool QGVLayerTilesOnline::isLoadBalancing() const
+{
+    return mLoadBalancing;
+}
 
-    request.setSslConfiguration(conf);
-    request.setRawHeader("User-Agent",
-                         "Mozilla/5.0 (Windows; U; MSIE "
-                         "6.0; Windows NT 5.1; SV1; .NET "
-                         "CLR 2.0.50727)");
-    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
-    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+QString QGVLayerTilesOnline::getTilesStoreId() const
+{
+    if (!mStoreId.isEmpty()) {
+        return mStoreId;
+    }
+    // Any mirror serves the same tiles, so id is built from the first one and not from the mirror chosen by layer
+    const QGV::GeoTilePos root(0, QPoint(0, 0));
+    return tilePosToMirrorUrls(root).value(0, tilePosToUrl(root));
+}
 
-    QNetworkReply* reply = QGV::getNetworkManager()->get(request);
+QGVTilesSeeder* QGVLayerTilesOnline::seed(const QGV::GeoRect& area, int fromZoom, int toZoom, int maxConcurrency)
+{
+    auto seeder = new QGVTilesSeeder(
+            getTilesStoreId(), [this](const QGV::GeoTilePos& tilePos) { return tileUrl(tilePos); }, this);
+    seeder->setArea(area);
+    seeder->setZoomRange(qMax(fromZoom, minZoomlevel()), qMin(toZoom, maxZoomlevel()));
+    seeder->setMaxConcurrency(maxConcurrency);
+    return seeder;
+}
 
-    mRequest[tilePos] = reply;
-    connect(reply, &QNetworkReply::finished, reply, [this, reply, tilePos]() { onReplyFinished(reply, tilePos); });
+QStringList QGVLayerTilesOnline::tilePosToMirrorUrls(const QGV::GeoTilePos& tilePos) const
+{
+    return { tilePosToUrl(tilePos) };
+}
 
-    qgvDebug() << "request" << url;
+QStringList QGVLayerTilesOnline::formatUrls(const QVector<QGVUrlTemplate>& templates,
+                                            const QGVUrlTemplate::Values& values)
+{
+    QStringList urls;
+    urls.reserve(templates.size());
+    for (const QGVUrlTemplate& urlTemplate : templates) {
+        urls.append(urlTemplate.format(values));
+    }
+    return urls;
+}
+
+QString QGVLayerTilesOnline::tileUrl(const QGV::GeoTilePos& tilePos, const QString& host) const
+{
+    if (!mLoadBalancing) {
+        return tilePosToUrl(tilePos);
+    }
+    const QStringList mirrors = tilePosToMirrorUrls(tilePos);
+    if (mirrors.size() < 2) {
+        return mirrors.value(0, tilePosToUrl(tilePos));
+    }
+    if (!host.isEmpty()) {
+        for (const QString& url : mirrors) {
+            if (urlHost(url) == host) {
+                return url;
+            }
+        }
+    }
+    const quint64 tileKey = tilePos.toKey();
+    const QGVTilesFetcher* fetcher = QGVTilesFetcher::globalFetcher();
+    QString bestUrl;
+    double bestScore = -1;
+    for (const QString& url : mirrors) {
+        const QString host = urlHost(url);
+        const double score = rendezvousScore(tileKey, host, fetcher->hostWeight(host));
+        if (score > bestScore) {
+            bestScore = score;
+            bestUrl = url;
+        }
+    }
+    return bestUrl;
+}
+
+void QGVLayerTilesOnline::request(const QGV::GeoTilePos& tilePos)
+{
+    // Weights may have changed since tile was queued, mirror must stay the one scheduler counts request for
+    QGVTilesFetcher::Request request;
+    request.url = tileUrl(tilePos, requestedHost(tilePos));
+    request.storeId = getTilesStoreId();
+    request.tilePos = tilePos;
+
+    const QString url = request.url;
+    mTickets[tilePos] = QGVTilesFetcher::globalFetcher()->fetch(
+            request, this, [this, tilePos, url](const QImage& image) { onTileFetched(tilePos, url, image); });
 }
 
 void QGVLayerTilesOnline::cancel(const QGV::GeoTilePos& tilePos)
 {
-    removeReply(tilePos);
+    const quint64 ticket = mTickets.take(tilePos);
+    if (ticket != 0) {
+        QGVTilesFetcher::globalFetcher()->cancel(ticket);
+    }
 }
 
-void QGVLayerTilesOnline::onReplyFinished(QNetworkReply* reply, const QGV::GeoTilePos& tilePos)
+QString QGVLayerTilesOnline::requestHost(const QGV::GeoTilePos& tilePos) const
 {
-    if (reply->error() != QNetworkReply::NoError) {
-        if (reply->error() != QNetworkReply::OperationCanceledError) {
-            qgvCritical() << "ERROR" << reply->errorString();
-        }
-        removeReply(tilePos);
+    return urlHost(tileUrl(tilePos));
+}
+
+void QGVLayerTilesOnline::onTileFetched(const QGV::GeoTilePos& tilePos, const QString& url, const QImage& image)
+{
+    mTickets.remove(tilePos);
+    if (image.isNull()) {
+        onTileFailed(tilePos);
         return;
     }
-    const auto rawImage = reply->readAll();
+    onTile(tilePos, createTile(tilePos, url, image));
+}
+
+void QGVLayerTilesOnline::onTileRefreshed(const QString& storeId, const QGV::GeoTilePos& tilePos, const QImage& image)
+{
+    if (storeId != getTilesStoreId() || getMap() == nullptr) {
+        return;
+    }
+    refreshTile(tilePos, createTile(tilePos, tileUrl(tilePos), image));
+}
+
+void QGVLayerTilesOnline::onCircuitClosed(const QString& storeId)
+{
+    if (storeId != getTilesStoreId() || getMap() == nullptr) {
+        return;
+    }
+    retryFailedTiles();
+}
+
+QGVDrawItem* QGVLayerTilesOnline::createTile(const QGV::GeoTilePos& tilePos,
+                                             const QString& url,
+                                             const QImage& image) const
+{
     auto tile = new QGVImage();
     tile->setGeometry(tilePos.toGeoRect());
-    tile->loadImage(rawImage);
+    tile->loadImage(image);
     tile->setProperty("drawDebug",
                       QString("%1\ntile(%2,%3,%4)")
-                              .arg(reply->url().toString())
+                              .arg(url)
                               .arg(tilePos.zoom())
                               .arg(tilePos.pos().x())
                               .arg(tilePos.pos().y()));
-    removeReply(tilePos);
-    onTile(tilePos, tile);
-}
-
-void QGVLayerTilesOnline::removeReply(const QGV::GeoTilePos& tilePos)
-{
-    QNetworkReply* reply = mRequest.value(tilePos, nullptr);
-    if (reply == nullptr) {
-        return;
-    }
-    mRequest.remove(tilePos);
-    reply->abort();
-    reply->close();
-    reply->deleteLater();
+    return tile;
 }
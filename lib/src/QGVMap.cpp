@@ -47,6 +47,7 @@ RootItem::~RootItem() = default;
 
 QGVMap::QGVMap(QWidget* parent)
     : QWidget(parent)
+    , mUpdateDepth(0)
 {
     mProjection.reset(new QGVProjectionEPSG3857());
     mQGView.reset(new QGVMapQGView(this));
@@ -69,6 +70,11 @@ const QGVCameraState QGVMap::getCamera() const
     return geoView()->getCamera();
 }
 
+QGV::MapState QGVMap::getState() const
+{
+    return geoView()->getState();
+}
+
 void QGVMap::cameraTo(const QGVCameraActions& actions, bool animation)
 {
     geoView()->cameraTo(actions, animation);
@@ -81,6 +87,22 @@ void QGVMap::flyTo(const QGVCameraActions& actions)
     fly->start(QAbstractAnimation::DeleteWhenStopped);
 }
 
+void QGVMap::prefetch(const QList<QGVCameraActions>& targets)
+{
+    const QGVCameraState origin = getCamera();
+    QList<QGVCameraState> targetStates;
+    for (const QGVCameraActions& target : targets) {
+        const double factor = origin.scale() / target.scale();
+        QRectF projRect(QPointF(0, 0), origin.projRect().size() * factor);
+        projRect.moveCenter(target.projCenter());
+        targetStates.append(QGVCameraState(this, target.azimuth(), target.scale(), projRect, false));
+    }
+    auto root = static_cast<RootItem*>(rootItem());
+    if (root->isVisible() && !targetStates.isEmpty()) {
+        root->onPrefetch(targetStates);
+    }
+}
+
 void QGVMap::setProjection(QGV::Projection id)
 {
     mProjection.reset(nullptr);
@@ -292,6 +314,54 @@ void QGVMap::refreshMap()
     mRootItem->update();
 }
 
+void QGVMap::beginUpdate()
+{
+    mUpdateDepth++;
+}
+
+void QGVMap::endUpdate()
+{
+    Q_ASSERT(mUpdateDepth > 0);
+    if (mUpdateDepth == 0 || --mUpdateDepth > 0) {
+        return;
+    }
+    const auto dirty = mDirtyItems;
+    mDirtyItems.clear();
+    QList<QPointer<QGVItem>> roots;
+    for (const QPointer<QGVItem>& item : dirty) {
+        if (item.isNull() || item->getMap() != this) {
+            continue;
+        }
+        bool covered = false;
+        for (QGVItem* parent = item->getParent(); parent != nullptr; parent = parent->getParent()) {
+            if (!dirty.value(parent).isNull()) {
+                covered = true;
+                break;
+            }
+        }
+        if (!covered) {
+            roots.append(item);
+        }
+    }
+    qgvDebug() << "batch update of" << roots.size() << "subtrees, dirty" << dirty.size();
+    // Update of one subtree may delete other dirty items
+    for (const QPointer<QGVItem>& item : roots) {
+        if (!item.isNull()) {
+            item->update();
+        }
+    }
+}
+
+bool QGVMap::isUpdating() const
+{
+    return mUpdateDepth > 0;
+}
+
+void QGVMap::markDirty(QGVItem* item)
+{
+    mDirtyItems.insert(item, item);
+}
+
 void QGVMap::refreshProjection()
 {
     QRectF sceneRect = mProjection->boundaryProjRect();
@@ -397,3 +467,18 @@ void QGVMap::mouseDoubleClickEvent(QMouseEvent* event)
     event->ignore();
     QWidget::mouseDoubleClickEvent(event);
 }
+
+QGVUpdateGuard::QGVUpdateGuard(QGVMap* geoMap)
+    : mGeoMap(geoMap)
+{
+    if (!mGeoMap.isNull()) {
+        mGeoMap->beginUpdate();
+    }
+}
+
+QGVUpdateGuard::~QGVUpdateGuard()
+{
+    if (!mGeoMap.isNull()) {
+        mGeoMap->endUpdate();
+    }
+}
@@ -26,7 +26,7 @@
 QGVMapQGItem::QGVMapQGItem(QGVDrawItem* geoObject)
 {
     mGeoObject = geoObject;
-    setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    setCacheMode(mGeoObject->projCacheMode());
 }
 
 QGVDrawItem* QGVMapQGItem::geoObjectFromQGItem(QGraphicsItem* item)
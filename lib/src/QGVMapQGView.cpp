@@ -114,6 +114,11 @@ void QGVMapQGView::setScaleLimits(double minScale, double maxScale)
     cameraScale(mScale);
 }
 
+QGV::MapState QGVMapQGView::getState() const
+{
+    return mState;
+}
+
 void QGVMapQGView::cleanState()
 {
     changeState(QGV::MapState::Idle);
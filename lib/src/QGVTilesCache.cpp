@@ -0,0 +1,205 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTilesCache.h"
+#include "QGVDrawItem.h"
+#include "Raster/QGVImage.h"
+
+#include <QCoreApplication>
+
+namespace {
+const qint64 defaultTileCost = 256 * 256 * 4;
+
+QGVTilesCache* createGlobalCache()
+{
+    // Never destroyed by static destructors: parked tiles hold pixmaps which must go before application
+    auto cache = new QGVTilesCache(128 * 1024 * 1024);
+    QCoreApplication* app = QCoreApplication::instance();
+    if (app != nullptr) {
+        QObject::connect(app, &QCoreApplication::aboutToQuit, app, [cache]() { cache->clear(); });
+    }
+    return cache;
+}
+}
+
+QGVTilesCache::QGVTilesCache(qint64 maxBytes)
+    : mMaxBytes(qMax(Q_INT64_C(0), maxBytes))
+    , mUsedBytes(0)
+{
+}
+
+QGVTilesCache::~QGVTilesCache()
+{
+    clear();
+}
+
+QGVTilesCache* QGVTilesCache::globalCache()
+{
+    static QGVTilesCache* cache = createGlobalCache();
+    return cache;
+}
+
+void QGVTilesCache::setMaxBytes(qint64 maxBytes)
+{
+    mMaxBytes = qMax(Q_INT64_C(0), maxBytes);
+    evict(mMaxBytes);
+    qgvDebug() << "tiles cache size changed to" << mMaxBytes;
+}
+
+qint64 QGVTilesCache::getMaxBytes() const
+{
+    return mMaxBytes;
+}
+
+qint64 QGVTilesCache::usedBytes() const
+{
+    return mUsedBytes;
+}
+
+int QGVTilesCache::count() const
+{
+    return mNodes.size();
+}
+
+void QGVTilesCache::insert(const QObject* owner, const QGV::GeoTilePos& tilePos, QGVDrawItem* tile)
+{
+    if (tile == nullptr) {
+        return;
+    }
+    const Key key(owner, tilePos.toKey());
+    auto it = mNodes.find(key);
+    if (it != mNodes.end()) {
+        mUsedBytes -= it.value()->cost;
+        if (it.value()->tile != tile) {
+            delete it.value()->tile;
+        }
+        mLru.erase(it.value());
+        mNodes.erase(it);
+    }
+    const qint64 cost = tileCost(tile);
+    if (cost > mMaxBytes) {
+        mStatistics.evictions++;
+        delete tile;
+        return;
+    }
+    evict(mMaxBytes - cost);
+    mLru.push_front(Node{ key, tile, cost });
+    mNodes.insert(key, mLru.begin());
+    mUsedBytes += cost;
+}
+
+QGVDrawItem* QGVTilesCache::take(const QObject* owner, const QGV::GeoTilePos& tilePos)
+{
+    auto it = mNodes.find(Key(owner, tilePos.toKey()));
+    if (it == mNodes.end()) {
+        mStatistics.misses++;
+        return nullptr;
+    }
+    mStatistics.hits++;
+    QGVDrawItem* tile = it.value()->tile;
+    mUsedBytes -= it.value()->cost;
+    mLru.erase(it.value());
+    mNodes.erase(it);
+    return tile;
+}
+
+void QGVTilesCache::remove(const QObject* owner, const QGV::GeoTilePos& tilePos)
+{
+    // Not a lookup, so statistics stay unchanged
+    auto it = mNodes.find(Key(owner, tilePos.toKey()));
+    if (it == mNodes.end()) {
+        return;
+    }
+    mUsedBytes -= it.value()->cost;
+    delete it.value()->tile;
+    mLru.erase(it.value());
+    mNodes.erase(it);
+}
+
+const QGVDrawItem* QGVTilesCache::find(const QObject* owner, const QGV::GeoTilePos& tilePos) const
+{
+    auto it = mNodes.constFind(Key(owner, tilePos.toKey()));
+    if (it == mNodes.constEnd()) {
+        return nullptr;
+    }
+    return it.value()->tile;
+}
+
+bool QGVTilesCache::contains(const QObject* owner, const QGV::GeoTilePos& tilePos) const
+{
+    return mNodes.contains(Key(owner, tilePos.toKey()));
+}
+
+void QGVTilesCache::clear(const QObject* owner)
+{
+    for (auto it = mLru.begin(); it != mLru.end();) {
+        if (it->key.first != owner) {
+            ++it;
+            continue;
+        }
+        mNodes.remove(it->key);
+        mUsedBytes -= it->cost;
+        delete it->tile;
+        it = mLru.erase(it);
+    }
+}
+
+void QGVTilesCache::clear()
+{
+    for (Node& node : mLru) {
+        delete node.tile;
+    }
+    mLru.clear();
+    mNodes.clear();
+    mUsedBytes = 0;
+}
+
+QGVTilesCache::Statistics QGVTilesCache::statistics() const
+{
+    Statistics result = mStatistics;
+    result.usedBytes = mUsedBytes;
+    result.maxBytes = mMaxBytes;
+    result.count = mNodes.size();
+    return result;
+}
+
+void QGVTilesCache::resetStatistics()
+{
+    mStatistics = {};
+}
+
+qint64 QGVTilesCache::tileCost(const QGVDrawItem* tile)
+{
+    auto image = qobject_cast<const QGVImage*>(tile);
+    if (image == nullptr || !image->isImage()) {
+        return defaultTileCost;
+    }
+    return qMax(Q_INT64_C(1), static_cast<qint64>(image->getImage().sizeInBytes()));
+}
+
+void QGVTilesCache::evict(qint64 maxBytes)
+{
+    while (!mLru.empty() && mUsedBytes > maxBytes) {
+        Node& node = mLru.back();
+        mNodes.remove(node.key);
+        mUsedBytes -= node.cost;
+        mStatistics.evictions++;
+        delete node.tile;
+        mLru.pop_back();
+    }
+}
@@ -0,0 +1,118 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTilesDecoder.h"
+
+#include <QCoreApplication>
+#include <QPointer>
+#include <QRunnable>
+#include <QThread>
+
+namespace {
+class DecodeTask : public QRunnable
+{
+public:
+    DecodeTask(const QGVTilesDecoder::Job& job, QObject* context, const QGVTilesDecoder::Callback& callback)
+        : mJob(job)
+        , mContext(context)
+        , mCallback(callback)
+    {
+    }
+
+    void run() override
+    {
+        // Context is checked only in GUI thread, job which may be dropped carries own cancel flag
+        const QImage image = mJob();
+        const QPointer<QObject> context = mContext;
+        const QGVTilesDecoder::Callback callback = mCallback;
+        QObject* receiver = QCoreApplication::instance();
+        if (receiver == nullptr) {
+            return;
+        }
+        QMetaObject::invokeMethod(
+                receiver,
+                [context, callback, image]() {
+                    if (!context.isNull()) {
+                        callback(image);
+                    }
+                },
+                Qt::QueuedConnection);
+    }
+
+private:
+    QGVTilesDecoder::Job mJob;
+    QPointer<QObject> mContext;
+    QGVTilesDecoder::Callback mCallback;
+};
+}
+
+QGVTilesDecoder::QGVTilesDecoder()
+{
+    mPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+QGVTilesDecoder::~QGVTilesDecoder()
+{
+    mPool.clear();
+    mPool.waitForDone();
+}
+
+QGVTilesDecoder* QGVTilesDecoder::globalDecoder()
+{
+    static QGVTilesDecoder decoder;
+    return &decoder;
+}
+
+void QGVTilesDecoder::setMaxThreadCount(int value)
+{
+    mPool.setMaxThreadCount(qMax(1, value));
+    qgvDebug() << "TilesDecoder threads changed to" << mPool.maxThreadCount();
+}
+
+int QGVTilesDecoder::getMaxThreadCount() const
+{
+    return mPool.maxThreadCount();
+}
+
+void QGVTilesDecoder::run(const Job& job, QObject* context, const Callback& callback)
+{
+    Q_ASSERT(context);
+    mPool.start(new DecodeTask(job, context, callback));
+}
+
+void QGVTilesDecoder::decode(const QByteArray& rawData, QObject* context, const Callback& callback)
+{
+    run([rawData]() { return decodeImage(rawData); }, context, callback);
+}
+
+void QGVTilesDecoder::waitForDone()
+{
+    mPool.waitForDone();
+}
+
+QImage QGVTilesDecoder::decodeImage(const QByteArray& rawData)
+{
+    QImage image;
+    if (!image.loadFromData(rawData)) {
+        return {};
+    }
+    if (image.format() != QImage::Format_ARGB32_Premultiplied) {
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+    return image;
+}
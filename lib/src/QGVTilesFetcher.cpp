@@ -0,0 +1,662 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTilesFetcher.h"
+#include "QGVTilesDecoder.h"
+#include "QGVTilesStore.h"
+
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QtMath>
+
+namespace {
+const double hostSmoothing = 0.2;
+const double hostFailureMs = 5000;
+const int hostWeightSteps = 4;
+const int maxRetryDelay = 30000;
+const int negativeCacheLimit = 4096;
+const int rejectedNegativeTimeout = 60 * 1000;
+const int maxRevalidationsActive = 2;
+const int maxRevalidationsQueued = 1024;
+
+QNetworkRequest tileRequest(const QUrl& url)
+{
+    QNetworkRequest request(url);
+    QSslConfiguration conf = request.sslConfiguration();
+    conf.setPeerVerifyMode(QSslSocket::VerifyNone);
+
+    request.setSslConfiguration(conf);
+    request.setRawHeader("User-Agent",
+                         "Mozilla/5.0 (Windows; U; MSIE "
+                         "6.0; Windows NT 5.1; SV1; .NET "
+                         "CLR 2.0.50727)");
+    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+    return request;
+}
+
+QGVTilesStore::Metadata replyMetadata(QNetworkReply* reply)
+{
+    QGVTilesStore::Metadata metadata;
+    metadata.timestamp = QDateTime::currentMSecsSinceEpoch();
+    metadata.etag = reply->rawHeader("ETag");
+    metadata.lastModified = reply->rawHeader("Last-Modified");
+    return metadata;
+}
+
+bool isMissingTile(QNetworkReply* reply)
+{
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    return status == 404 || status == 410 || reply->error() == QNetworkReply::ContentNotFoundError;
+}
+
+bool isTransientError(QNetworkReply* reply)
+{
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status >= 400 && status < 500) {
+        return status == 408 || status == 429;
+    }
+    return true;
+}
+}
+
+QGVTilesFetcher::QGVTilesFetcher()
+    : mLastTicket(0)
+    , mLastJob(0)
+    , mRevalidationsActive(0)
+    , mMaxRetries(3)
+    , mRetryDelay(500)
+    , mNegativeTimeout(5 * 60 * 1000)
+    , mCircuitFailures(8)
+    , mCircuitTimeout(30 * 1000)
+    , mMaxAge(7LL * 24 * 60 * 60 * 1000)
+{
+    mClock.start();
+}
+
+QGVTilesFetcher* QGVTilesFetcher::globalFetcher()
+{
+    static QGVTilesFetcher fetcher;
+    return &fetcher;
+}
+
+quint64 QGVTilesFetcher::fetch(const Request& request, QObject* subscriber, const Callback& callback)
+{
+    return subscribe(request, Subscriber{ subscriber, callback, {} }, false);
+}
+
+quint64 QGVTilesFetcher::prefetch(const Request& request, QObject* subscriber, const StoredCallback& callback)
+{
+    return subscribe(request, Subscriber{ subscriber, {}, callback }, true);
+}
+
+quint64 QGVTilesFetcher::subscribe(const Request& request, const Subscriber& subscriber, bool storeOnly)
+{
+    const quint64 ticket = ++mLastTicket;
+    const Key key(request.storeId, request.tilePos.toKey());
+    mStatistics.requests++;
+    mTickets.insert(ticket, key);
+
+    auto it = mJobs.find(key);
+    if (it != mJobs.end()) {
+        mStatistics.coalesced++;
+        // Tile is decoded if anyone needs image, store-only subscribers are satisfied by it too
+        it.value().storeOnly = it.value().storeOnly && storeOnly;
+        it.value().subscribers.insert(ticket, subscriber);
+        qgvDebug() << "coalesce" << request.url;
+        return ticket;
+    }
+
+    Job job;
+    job.request = request;
+    job.id = ++mLastJob;
+    job.storeOnly = storeOnly;
+    job.subscribers.insert(ticket, subscriber);
+    mJobs.insert(key, job);
+
+    QGVTilesStore* store = QGV::getTilesStore();
+    if (isNegative(key)) {
+        mStatistics.negativeHits++;
+        failLater(key, job.id);
+    } else if (store != nullptr && store->contains(request.storeId, request.tilePos)) {
+        if (storeOnly) {
+            storedLater(key, job.id);
+        } else {
+            startStore(key);
+        }
+    } else {
+        startNetwork(key);
+    }
+    return ticket;
+}
+
+void QGVTilesFetcher::cancel(quint64 ticket)
+{
+    auto ticketIt = mTickets.find(ticket);
+    if (ticketIt == mTickets.end()) {
+        return;
+    }
+    const Key key = ticketIt.value();
+    mTickets.erase(ticketIt);
+    auto it = mJobs.find(key);
+    if (it == mJobs.end()) {
+        return;
+    }
+    it.value().subscribers.remove(ticket);
+    if (!it.value().subscribers.isEmpty()) {
+        return;
+    }
+    mStatistics.canceled++;
+    QNetworkReply* reply = it.value().reply;
+    if (it.value().probe) {
+        mBreakers[key.first].probing = false;
+    }
+    mJobs.erase(it);
+    if (reply != nullptr) {
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+int QGVTilesFetcher::activeCount() const
+{
+    return mJobs.size();
+}
+
+QGVTilesFetcher::Statistics QGVTilesFetcher::statistics() const
+{
+    return mStatistics;
+}
+
+void QGVTilesFetcher::resetStatistics()
+{
+    mStatistics = {};
+    mHosts.clear();
+}
+
+void QGVTilesFetcher::setMaxRetries(int value)
+{
+    mMaxRetries = qMax(0, value);
+    qgvDebug() << "MaxRetries changed to" << mMaxRetries;
+}
+
+int QGVTilesFetcher::getMaxRetries() const
+{
+    return mMaxRetries;
+}
+
+void QGVTilesFetcher::setRetryDelay(int msec)
+{
+    mRetryDelay = qMax(1, msec);
+    qgvDebug() << "RetryDelay changed to" << mRetryDelay;
+}
+
+int QGVTilesFetcher::getRetryDelay() const
+{
+    return mRetryDelay;
+}
+
+void QGVTilesFetcher::setNegativeCacheTimeout(int msec)
+{
+    mNegativeTimeout = qMax(0, msec);
+    if (mNegativeTimeout == 0) {
+        mNegative.clear();
+    }
+    qgvDebug() << "NegativeCacheTimeout changed to" << mNegativeTimeout;
+}
+
+int QGVTilesFetcher::getNegativeCacheTimeout() const
+{
+    return mNegativeTimeout;
+}
+
+void QGVTilesFetcher::setCircuitBreaker(int failures, int timeoutMsec)
+{
+    mCircuitFailures = qMax(0, failures);
+    mCircuitTimeout = qMax(0, timeoutMsec);
+    if (mCircuitFailures == 0) {
+        mBreakers.clear();
+    }
+    qgvDebug() << "CircuitBreaker changed to" << mCircuitFailures << mCircuitTimeout;
+}
+
+void QGVTilesFetcher::setTilesMaxAge(qint64 msec)
+{
+    mMaxAge = qMax<qint64>(0, msec);
+    qgvDebug() << "TilesMaxAge changed to" << mMaxAge;
+}
+
+qint64 QGVTilesFetcher::getTilesMaxAge() const
+{
+    return mMaxAge;
+}
+
+QGVTilesFetcher::CircuitState QGVTilesFetcher::circuitState(const QString& storeId) const
+{
+    const Breaker breaker = mBreakers.value(storeId);
+    if (breaker.openUntil == 0) {
+        return CircuitState::Closed;
+    }
+    if (breaker.probing || mClock.elapsed() >= breaker.openUntil) {
+        return CircuitState::HalfOpen;
+    }
+    return CircuitState::Open;
+}
+
+QStringList QGVTilesFetcher::hosts() const
+{
+    return mHosts.keys();
+}
+
+QGVTilesFetcher::HostStatistics QGVTilesFetcher::hostStatistics(const QString& host) const
+{
+    return mHosts.value(host);
+}
+
+double QGVTilesFetcher::hostWeight(const QString& host) const
+{
+    const auto it = mHosts.constFind(host);
+    if (it == mHosts.constEnd() || it.value().requests == 0) {
+        return 1.0;
+    }
+    double best = it.value().latencyMs;
+    for (const HostStatistics& stat : mHosts) {
+        if (stat.requests > 0) {
+            best = qMin(best, stat.latencyMs);
+        }
+    }
+    // Weight is halved for every doubling of latency compared to fastest host. Quantization keeps weights
+    // (and so mirror chosen for every tile) unchanged by small fluctuations.
+    const double ratio = it.value().latencyMs / qMax(best, 1.0);
+    const int steps = qBound(0, qRound(std::log2(qMax(ratio, 1.0))), hostWeightSteps);
+    return 1.0 / (1 << steps);
+}
+
+void QGVTilesFetcher::startStore(const Key& key)
+{
+    const Job& job = mJobs[key];
+    const quint64 jobId = job.id;
+    const QString storeId = job.request.storeId;
+    const QGV::GeoTilePos tilePos = job.request.tilePos;
+    QGVTilesStore* store = QGV::getTilesStore();
+    mStatistics.fromStore++;
+    // Store is read in worker thread too, metadata is checked for age when decoded image is delivered
+    const QSharedPointer<QGVTilesStore::Metadata> metadata(new QGVTilesStore::Metadata());
+    QGVTilesDecoder::globalDecoder()->run(
+            [store, storeId, tilePos, metadata]() {
+                return QGVTilesDecoder::decodeImage(store->read(storeId, tilePos, metadata.data()));
+            },
+            this,
+            [this, key, jobId, metadata](const QImage& image) {
+                const qint64 age = QDateTime::currentMSecsSinceEpoch() - metadata->timestamp;
+                if (!image.isNull() && mMaxAge > 0 && age > mMaxAge && mJobs.contains(key)) {
+                    revalidate(key, *metadata);
+                }
+                onDecoded(key, jobId, image, true);
+            });
+    qgvDebug() << "request from store" << job.request.url;
+}
+
+void QGVTilesFetcher::startNetwork(const Key& key)
+{
+    Q_ASSERT(QGV::getNetworkManager());
+
+    Job& job = mJobs[key];
+    if (!acquireCircuit(job)) {
+        mStatistics.rejected++;
+        qgvDebug() << "circuit open, reject" << job.request.url;
+        failLater(key, job.id);
+        return;
+    }
+    const QUrl url(job.request.url);
+
+    QNetworkRequest request = tileRequest(url);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+
+    QNetworkReply* reply = QGV::getNetworkManager()->get(request);
+    const quint64 jobId = job.id;
+    job.reply = reply;
+    job.timer.start();
+    mStatistics.fromNetwork++;
+    connect(reply, &QNetworkReply::finished, this, [this, key, jobId, reply]() {
+        onReplyFinished(key, jobId, reply);
+    });
+
+    qgvDebug() << "request" << url;
+}
+
+void QGVTilesFetcher::onReplyFinished(const Key& key, quint64 jobId, QNetworkReply* reply)
+{
+    auto it = mJobs.find(key);
+    if (it == mJobs.end() || it.value().id != jobId || it.value().reply != reply) {
+        return;
+    }
+    Job& job = it.value();
+    job.reply = nullptr;
+    job.probe = false;
+    reply->deleteLater();
+    QMetaObject::invokeMethod(this, [this]() { startRevalidations(); }, Qt::QueuedConnection);
+    const QString host = reply->url().host();
+    const qint64 elapsedMs = job.timer.elapsed();
+    if (reply->error() != QNetworkReply::NoError) {
+        qgvCritical() << "ERROR" << reply->errorString();
+        const bool missing = isMissingTile(reply);
+        const bool transient = !missing && isTransientError(reply);
+        updateHost(host, elapsedMs, 0, transient);
+        // Rejected requests (e.g. 401, 403, TLS) count too, provider which refuses everything must be paused
+        reportCircuit(job.request.storeId, !missing);
+        if (missing) {
+            insertNegative(key, mNegativeTimeout);
+        } else if (!transient) {
+            insertNegative(key, qMin(mNegativeTimeout, rejectedNegativeTimeout));
+        }
+        if (!transient || job.attempt >= mMaxRetries) {
+            finish(key, {});
+            return;
+        }
+        const int delay = static_cast<int>(qMin<qint64>(qint64(mRetryDelay) << qMin(job.attempt, 16), maxRetryDelay));
+        const int jittered = delay / 2 + static_cast<int>(QRandomGenerator::global()->bounded(delay / 2 + 1));
+        job.attempt++;
+        mStatistics.retries++;
+        qgvDebug() << "retry" << job.attempt << "in" << jittered << "ms" << job.request.url;
+        QTimer::singleShot(jittered, this, [this, key, jobId]() { onRetry(key, jobId); });
+        return;
+    }
+    const QByteArray rawImage = reply->readAll();
+    const QGVTilesStore::Metadata metadata = replyMetadata(reply);
+    updateHost(host, elapsedMs, rawImage.size(), false);
+    reportCircuit(job.request.storeId, false);
+    if (rawImage.isEmpty()) {
+        qgvDebug() << "empty tile" << job.request.url;
+        insertNegative(key, mNegativeTimeout);
+        finish(key, {});
+        return;
+    }
+    if (job.storeOnly) {
+        // Successful reply is enough, data is checked by decoding when tile is read from store
+        writeStore(key, rawImage, metadata);
+        finish(key, {}, true);
+        return;
+    }
+    QGVTilesDecoder::globalDecoder()->run(
+            [rawImage]() { return QGVTilesDecoder::decodeImage(rawImage); },
+            this,
+            [this, key, jobId, rawImage, metadata](const QImage& image) {
+                if (!image.isNull()) {
+                    writeStore(key, rawImage, metadata);
+                }
+                onDecoded(key, jobId, image, false);
+            });
+}
+
+void QGVTilesFetcher::onRetry(const Key& key, quint64 jobId)
+{
+    auto it = mJobs.find(key);
+    if (it == mJobs.end() || it.value().id != jobId || it.value().reply != nullptr) {
+        return;
+    }
+    startNetwork(key);
+}
+
+void QGVTilesFetcher::failLater(const Key& key, quint64 jobId)
+{
+    QMetaObject::invokeMethod(
+            this, [this, key, jobId]() { onDecoded(key, jobId, {}, false); }, Qt::QueuedConnection);
+}
+
+void QGVTilesFetcher::onDecoded(const Key& key, quint64 jobId, const QImage& image, bool fromStore)
+{
+    auto it = mJobs.find(key);
+    if (it == mJobs.end() || it.value().id != jobId) {
+        qgvDebug() << "drop stale decode";
+        return;
+    }
+    if (image.isNull() && fromStore) {
+        qgvDebug() << "broken tile in store" << it.value().request.url;
+        startNetwork(key);
+        return;
+    }
+    finish(key, image);
+}
+
+void QGVTilesFetcher::storedLater(const Key& key, quint64 jobId)
+{
+    QMetaObject::invokeMethod(
+            this,
+            [this, key, jobId]() {
+                auto it = mJobs.find(key);
+                if (it == mJobs.end() || it.value().id != jobId) {
+                    return;
+                }
+                if (it.value().storeOnly) {
+                    finish(key, {}, true);
+                } else {
+                    // Subscriber which needs image joined meanwhile
+                    startStore(key);
+                }
+            },
+            Qt::QueuedConnection);
+}
+
+void QGVTilesFetcher::finish(const Key& key, const QImage& image, bool stored)
+{
+    const Job job = mJobs.take(key);
+    const bool succeeded = stored || !image.isNull();
+    if (!succeeded) {
+        mStatistics.failed++;
+    }
+    for (auto it = job.subscribers.constBegin(); it != job.subscribers.constEnd(); ++it) {
+        mTickets.remove(it.key());
+    }
+    for (const Subscriber& subscriber : job.subscribers) {
+        if (subscriber.context.isNull()) {
+            continue;
+        }
+        if (subscriber.callback) {
+            subscriber.callback(image);
+        } else {
+            subscriber.stored(succeeded);
+        }
+    }
+}
+
+void QGVTilesFetcher::revalidate(const Key& key, const QGVTilesStore::Metadata& metadata)
+{
+    if (mRevalidating.contains(key) || mRevalidations.size() >= maxRevalidationsQueued) {
+        return;
+    }
+    mRevalidating.insert(key);
+    mRevalidations.append(Revalidation{ mJobs[key].request, metadata });
+    QMetaObject::invokeMethod(this, [this]() { startRevalidations(); }, Qt::QueuedConnection);
+}
+
+void QGVTilesFetcher::startRevalidations()
+{
+    // Revalidation has lowest priority: it waits until all requests for visible tiles are finished
+    for (const Job& job : mJobs) {
+        if (job.reply != nullptr) {
+            return;
+        }
+    }
+    while (mRevalidationsActive < maxRevalidationsActive && !mRevalidations.isEmpty()) {
+        const Revalidation revalidation = mRevalidations.takeFirst();
+        const Key key(revalidation.request.storeId, revalidation.request.tilePos.toKey());
+        if (circuitState(key.first) != CircuitState::Closed || QGV::getNetworkManager() == nullptr) {
+            mRevalidating.remove(key);
+            continue;
+        }
+        QNetworkRequest request = tileRequest(QUrl(revalidation.request.url));
+        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+        request.setPriority(QNetworkRequest::LowPriority);
+        if (!revalidation.metadata.etag.isEmpty()) {
+            request.setRawHeader("If-None-Match", revalidation.metadata.etag);
+        }
+        if (!revalidation.metadata.lastModified.isEmpty()) {
+            request.setRawHeader("If-Modified-Since", revalidation.metadata.lastModified);
+        }
+        QNetworkReply* reply = QGV::getNetworkManager()->get(request);
+        mRevalidationsActive++;
+        mStatistics.revalidations++;
+        connect(reply, &QNetworkReply::finished, this, [this, key, reply]() { onRevalidated(key, reply); });
+        qgvDebug() << "revalidate" << revalidation.request.url;
+    }
+}
+
+void QGVTilesFetcher::onRevalidated(const Key& key, QNetworkReply* reply)
+{
+    reply->deleteLater();
+    mRevalidationsActive--;
+    mRevalidating.remove(key);
+    const QGV::GeoTilePos tilePos = QGV::GeoTilePos::fromKey(key.second);
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QGVTilesStore* store = QGV::getTilesStore();
+    if (store == nullptr || reply->error() != QNetworkReply::NoError) {
+        qgvDebug() << "revalidation failed" << reply->url() << reply->errorString();
+    } else if (status == 304) {
+        mStatistics.notModified++;
+        QGVTilesStore::Metadata metadata;
+        store->readMetadata(key.first, tilePos, metadata);
+        const QGVTilesStore::Metadata fresh = replyMetadata(reply);
+        metadata.timestamp = fresh.timestamp;
+        metadata.etag = fresh.etag.isEmpty() ? metadata.etag : fresh.etag;
+        metadata.lastModified = fresh.lastModified.isEmpty() ? metadata.lastModified : fresh.lastModified;
+        store->updateMetadata(key.first, tilePos, metadata);
+    } else {
+        mStatistics.refreshed++;
+        const QByteArray rawImage = reply->readAll();
+        const QGVTilesStore::Metadata metadata = replyMetadata(reply);
+        QGVTilesDecoder::globalDecoder()->run(
+                [rawImage]() { return QGVTilesDecoder::decodeImage(rawImage); },
+                this,
+                [this, key, tilePos, rawImage, metadata](const QImage& image) {
+                    if (image.isNull()) {
+                        return;
+                    }
+                    writeStore(key, rawImage, metadata);
+                    Q_EMIT tileRefreshed(key.first, tilePos, image);
+                });
+    }
+    startRevalidations();
+}
+
+void QGVTilesFetcher::writeStore(const Key& key, const QByteArray& rawImage, const QGVTilesStore::Metadata& metadata)
+{
+    // Store is looked up again, it may be replaced or gone while tile was decoded
+    QGVTilesStore* store = QGV::getTilesStore();
+    if (store != nullptr) {
+        store->write(key.first, QGV::GeoTilePos::fromKey(key.second), rawImage, metadata);
+    }
+}
+
+bool QGVTilesFetcher::acquireCircuit(Job& job)
+{
+    if (mCircuitFailures == 0) {
+        return true;
+    }
+    auto it = mBreakers.find(job.request.storeId);
+    if (it == mBreakers.end() || it.value().openUntil == 0) {
+        return true;
+    }
+    Breaker& breaker = it.value();
+    if (breaker.probing || mClock.elapsed() < breaker.openUntil) {
+        return false;
+    }
+    qgvDebug() << "circuit half-open, probe" << job.request.url;
+    breaker.probing = true;
+    job.probe = true;
+    return true;
+}
+
+void QGVTilesFetcher::reportCircuit(const QString& storeId, bool failed)
+{
+    if (mCircuitFailures == 0) {
+        return;
+    }
+    if (!failed) {
+        const Breaker breaker = mBreakers.take(storeId);
+        if (breaker.openUntil != 0) {
+            qgvDebug() << "circuit closed" << storeId;
+            Q_EMIT circuitClosed(storeId);
+        }
+        return;
+    }
+    Breaker& breaker = mBreakers[storeId];
+    breaker.probing = false;
+    breaker.failures++;
+    if (breaker.openUntil != 0 || breaker.failures >= mCircuitFailures) {
+        if (breaker.openUntil == 0) {
+            mStatistics.circuitTrips++;
+            qgvCritical() << "circuit open" << storeId;
+        }
+        breaker.openUntil = mClock.elapsed() + mCircuitTimeout;
+    }
+}
+
+bool QGVTilesFetcher::isNegative(const Key& key)
+{
+    auto it = mNegative.find(key);
+    if (it == mNegative.end()) {
+        return false;
+    }
+    if (mClock.elapsed() < it.value()) {
+        return true;
+    }
+    mNegative.erase(it);
+    return false;
+}
+
+void QGVTilesFetcher::insertNegative(const Key& key, int timeout)
+{
+    if (timeout == 0) {
+        return;
+    }
+    const qint64 now = mClock.elapsed();
+    if (mNegative.size() >= negativeCacheLimit) {
+        for (auto it = mNegative.begin(); it != mNegative.end();) {
+            if (it.value() <= now) {
+                it = mNegative.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (mNegative.size() >= negativeCacheLimit) {
+            mNegative.clear();
+        }
+    }
+    mNegative.insert(key, now + timeout);
+}
+
+void QGVTilesFetcher::updateHost(const QString& host, qint64 elapsedMs, qint64 bytes, bool failed)
+{
+    if (host.isEmpty()) {
+        return;
+    }
+    HostStatistics& stat = mHosts[host];
+    const double latencyMs = failed ? qMax(static_cast<double>(elapsedMs), hostFailureMs) : elapsedMs;
+    const double alpha = (stat.requests == 0) ? 1.0 : hostSmoothing;
+    stat.requests++;
+    stat.latencyMs += alpha * (latencyMs - stat.latencyMs);
+    if (failed) {
+        stat.failed++;
+        return;
+    }
+    stat.bytes += bytes;
+    const double bytesPerSecond = bytes * 1000.0 / qMax<qint64>(elapsedMs, 1);
+    stat.bytesPerSecond += alpha * (bytesPerSecond - stat.bytesPerSecond);
+}
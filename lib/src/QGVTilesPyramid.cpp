@@ -0,0 +1,175 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTilesPyramid.h"
+
+#include <algorithm>
+
+namespace {
+const int levelsCount = 32;
+const QGVTilesPyramid::Level emptyLevel;
+}
+
+QGVTilesPyramid::QGVTilesPyramid()
+    : mLevels(levelsCount)
+    , mCount(0)
+{
+}
+
+void QGVTilesPyramid::clear()
+{
+    for (Level& level : mLevels) {
+        level.clear();
+    }
+    mCount = 0;
+}
+
+bool QGVTilesPyramid::isEmpty() const
+{
+    return mCount == 0;
+}
+
+int QGVTilesPyramid::count() const
+{
+    return mCount;
+}
+
+int QGVTilesPyramid::count(int zoom) const
+{
+    return level(zoom).size();
+}
+
+bool QGVTilesPyramid::contains(const QGV::GeoTilePos& tilePos) const
+{
+    return level(tilePos.zoom()).contains(tilePos.toKey());
+}
+
+QGVDrawItem* QGVTilesPyramid::value(const QGV::GeoTilePos& tilePos) const
+{
+    return level(tilePos.zoom()).value(tilePos.toKey(), nullptr);
+}
+
+void QGVTilesPyramid::insert(const QGV::GeoTilePos& tilePos, QGVDrawItem* tile)
+{
+    if (!isValidZoom(tilePos.zoom())) {
+        return;
+    }
+    Level& target = mLevels[tilePos.zoom()];
+    const int before = target.size();
+    target.insert(tilePos.toKey(), tile);
+    mCount += target.size() - before;
+}
+
+QGVDrawItem* QGVTilesPyramid::take(const QGV::GeoTilePos& tilePos)
+{
+    if (!isValidZoom(tilePos.zoom())) {
+        return nullptr;
+    }
+    Level& target = mLevels[tilePos.zoom()];
+    auto it = target.find(tilePos.toKey());
+    if (it == target.end()) {
+        return nullptr;
+    }
+    QGVDrawItem* tile = it.value();
+    target.erase(it);
+    mCount--;
+    return tile;
+}
+
+int QGVTilesPyramid::levels() const
+{
+    return mLevels.size();
+}
+
+const QGVTilesPyramid::Level& QGVTilesPyramid::level(int zoom) const
+{
+    if (!isValidZoom(zoom)) {
+        return emptyLevel;
+    }
+    return mLevels.at(zoom);
+}
+
+void QGVTilesPyramid::keys(int zoom, QVector<QGV::GeoTilePos>& result) const
+{
+    const Level& source = level(zoom);
+    result.reserve(result.size() + source.size());
+    for (auto it = source.constBegin(); it != source.constEnd(); ++it) {
+        result.append(QGV::GeoTilePos::fromKey(it.key()));
+    }
+}
+
+QGV::GeoTilePos QGVTilesPyramid::findAncestor(const QGV::GeoTilePos& tilePos, int minZoom) const
+{
+    const int x = tilePos.pos().x();
+    const int y = tilePos.pos().y();
+    for (int zoom = tilePos.zoom() - 1; zoom >= qMax(0, minZoom); --zoom) {
+        const int shift = tilePos.zoom() - zoom;
+        const QGV::GeoTilePos ancestor(zoom, QPoint(x >> shift, y >> shift));
+        if (contains(ancestor)) {
+            return ancestor;
+        }
+    }
+    return {};
+}
+
+void QGVTilesPyramid::findChildren(const QGV::GeoTilePos& tilePos, QVector<QGV::GeoTilePos>& result) const
+{
+    findDescendants(tilePos, tilePos.zoom() + 1, result);
+}
+
+/*!
+ * Existing tiles of given zoom which are covered by tilePos.
+ * Result is ordered by tile key (column by column), small areas are probed directly and large ones are scanned.
+ */
+void QGVTilesPyramid::findDescendants(const QGV::GeoTilePos& tilePos, int zoom, QVector<QGV::GeoTilePos>& result) const
+{
+    const int deltaZoom = zoom - tilePos.zoom();
+    const Level& source = level(zoom);
+    if (deltaZoom <= 0 || source.isEmpty()) {
+        return;
+    }
+    const int first = result.size();
+    const qint64 side = Q_INT64_C(1) << qMin(deltaZoom, 31);
+    if (deltaZoom < 16 && side * side <= source.size()) {
+        const int x0 = tilePos.pos().x() << deltaZoom;
+        const int y0 = tilePos.pos().y() << deltaZoom;
+        for (int x = x0; x < x0 + side; ++x) {
+            for (int y = y0; y < y0 + side; ++y) {
+                const QGV::GeoTilePos target(zoom, QPoint(x, y));
+                if (source.contains(target.toKey())) {
+                    result.append(target);
+                }
+            }
+        }
+        return;
+    }
+    for (auto it = source.constBegin(); it != source.constEnd(); ++it) {
+        const QGV::GeoTilePos target = QGV::GeoTilePos::fromKey(it.key());
+        const bool sameX = (target.pos().x() >> deltaZoom) == tilePos.pos().x();
+        const bool sameY = (target.pos().y() >> deltaZoom) == tilePos.pos().y();
+        if (sameX && sameY) {
+            result.append(target);
+        }
+    }
+    std::sort(result.begin() + first, result.end());
+}
+
+bool QGVTilesPyramid::isValidZoom(int zoom) const
+{
+    return zoom >= 0 && zoom < levelsCount;
+}
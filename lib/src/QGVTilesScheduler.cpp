@@ -0,0 +1,282 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTilesScheduler.h"
+
+#include <QSet>
+#include <QtMath>
+
+#include <algorithm>
+
+namespace {
+const double zoomPenalty = 8.0;
+const double prefetchPenalty = 1.0e6;
+size_t maxRequestsPerHost = 6;
+QHash<QString, size_t> hostLimits;
+QHash<QString, int> hostsInFlight;
+QSet<QGVTilesScheduler*> schedulers;
+}
+
+QGVTilesScheduler::QGVTilesScheduler(QObject* owner, const Dispatcher& dispatcher)
+    : mOwner(owner)
+    , mDispatcher(dispatcher)
+    , mMaxInFlight(0)
+    , mZoom(-1)
+    , mOrderDirty(false)
+{
+    schedulers.insert(this);
+}
+
+QGVTilesScheduler::~QGVTilesScheduler()
+{
+    schedulers.remove(this);
+    clear();
+}
+
+void QGVTilesScheduler::setMaxRequestsPerHost(size_t value)
+{
+    maxRequestsPerHost = value;
+    qgvDebug() << "MaxRequestsPerHost changed to" << value;
+    wakeAll();
+}
+
+size_t QGVTilesScheduler::getMaxRequestsPerHost()
+{
+    return maxRequestsPerHost;
+}
+
+void QGVTilesScheduler::setMaxRequestsPerHost(const QString& host, size_t value)
+{
+    hostLimits[host] = value;
+    qgvDebug() << "MaxRequestsPerHost for" << host << "changed to" << value;
+    wakeAll();
+}
+
+void QGVTilesScheduler::resetMaxRequestsPerHost(const QString& host)
+{
+    hostLimits.remove(host);
+    qgvDebug() << "MaxRequestsPerHost for" << host << "reset to" << maxRequestsPerHost;
+    wakeAll();
+}
+
+size_t QGVTilesScheduler::getMaxRequestsPerHost(const QString& host)
+{
+    return hostLimits.value(host, maxRequestsPerHost);
+}
+
+int QGVTilesScheduler::hostInFlightCount(const QString& host)
+{
+    return hostsInFlight.value(host, 0);
+}
+
+void QGVTilesScheduler::setMaxRequestsInFlight(size_t value)
+{
+    mMaxInFlight = value;
+}
+
+size_t QGVTilesScheduler::getMaxRequestsInFlight() const
+{
+    return mMaxInFlight;
+}
+
+void QGVTilesScheduler::setView(int zoom, const QPointF& center)
+{
+    if (mZoom == zoom && mCenter == center) {
+        return;
+    }
+    mZoom = zoom;
+    mCenter = center;
+    mOrderDirty = true;
+}
+
+void QGVTilesScheduler::enqueue(const QGV::GeoTilePos& tilePos, const QString& host, int prefetchLevel)
+{
+    const quint64 key = tilePos.toKey();
+    if (mInFlight.contains(key)) {
+        return;
+    }
+    auto it = mQueued.find(key);
+    if (it != mQueued.end()) {
+        if (prefetchLevel < it.value().prefetchLevel) {
+            it.value().prefetchLevel = prefetchLevel;
+            mOrderDirty = true;
+        }
+        return;
+    }
+    mQueued.insert(key, Request{ host, prefetchLevel });
+    mOrder.append(Entry{ key, priority(tilePos, prefetchLevel) });
+    mOrderDirty = true;
+}
+
+bool QGVTilesScheduler::dequeue(const QGV::GeoTilePos& tilePos)
+{
+    return mQueued.remove(tilePos.toKey()) > 0;
+}
+
+void QGVTilesScheduler::clearPrefetch()
+{
+    for (auto it = mQueued.begin(); it != mQueued.end();) {
+        if (it.value().prefetchLevel > 0) {
+            it = mQueued.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool QGVTilesScheduler::takeNext(QGV::GeoTilePos& tilePos)
+{
+    if (mQueued.isEmpty() || isLayerSaturated()) {
+        return false;
+    }
+    if (mOrderDirty) {
+        mOrder.erase(std::remove_if(mOrder.begin(),
+                                    mOrder.end(),
+                                    [this](const Entry& entry) { return !mQueued.contains(entry.key); }),
+                     mOrder.end());
+        for (Entry& entry : mOrder) {
+            entry.priority = priority(QGV::GeoTilePos::fromKey(entry.key), mQueued.value(entry.key).prefetchLevel);
+        }
+        std::sort(mOrder.begin(), mOrder.end(), [](const Entry& left, const Entry& right) {
+            return left.priority > right.priority;
+        });
+        mOrderDirty = false;
+    }
+    for (int i = mOrder.size() - 1; i >= 0; --i) {
+        const quint64 key = mOrder[i].key;
+        auto it = mQueued.find(key);
+        if (it == mQueued.end()) {
+            mOrder.remove(i);
+            continue;
+        }
+        const QString host = it.value().host;
+        if (isHostSaturated(host)) {
+            continue;
+        }
+        mOrder.remove(i);
+        mQueued.erase(it);
+        mInFlight.insert(key, host);
+        if (!host.isEmpty()) {
+            hostsInFlight[host]++;
+        }
+        tilePos = QGV::GeoTilePos::fromKey(key);
+        return true;
+    }
+    return false;
+}
+
+void QGVTilesScheduler::finished(const QGV::GeoTilePos& tilePos)
+{
+    auto it = mInFlight.find(tilePos.toKey());
+    if (it == mInFlight.end()) {
+        return;
+    }
+    const QString host = it.value();
+    mInFlight.erase(it);
+    releaseHost(host);
+}
+
+void QGVTilesScheduler::clear()
+{
+    const auto inFlight = mInFlight;
+    mInFlight.clear();
+    mQueued.clear();
+    mOrder.clear();
+    mOrderDirty = false;
+    for (const QString& host : inFlight) {
+        releaseHost(host);
+    }
+}
+
+bool QGVTilesScheduler::isQueued(const QGV::GeoTilePos& tilePos) const
+{
+    return mQueued.contains(tilePos.toKey());
+}
+
+bool QGVTilesScheduler::isInFlight(const QGV::GeoTilePos& tilePos) const
+{
+    return mInFlight.contains(tilePos.toKey());
+}
+
+QString QGVTilesScheduler::inFlightHost(const QGV::GeoTilePos& tilePos) const
+{
+    return mInFlight.value(tilePos.toKey());
+}
+
+int QGVTilesScheduler::queuedCount() const
+{
+    return mQueued.size();
+}
+
+int QGVTilesScheduler::inFlightCount() const
+{
+    return mInFlight.size();
+}
+
+double QGVTilesScheduler::priority(const QGV::GeoTilePos& tilePos, int prefetchLevel) const
+{
+    if (mZoom < 0) {
+        return prefetchLevel * prefetchPenalty;
+    }
+    const int zoomDelta = mZoom - tilePos.zoom();
+    const double factor = qPow(2.0, zoomDelta);
+    const double dx = (tilePos.pos().x() + 0.5) * factor - mCenter.x();
+    const double dy = (tilePos.pos().y() + 0.5) * factor - mCenter.y();
+    return qSqrt(dx * dx + dy * dy) + qAbs(zoomDelta) * zoomPenalty + prefetchLevel * prefetchPenalty;
+}
+
+bool QGVTilesScheduler::isLayerSaturated() const
+{
+    return mMaxInFlight > 0 && static_cast<size_t>(mInFlight.size()) >= mMaxInFlight;
+}
+
+bool QGVTilesScheduler::isHostSaturated(const QString& host)
+{
+    if (host.isEmpty()) {
+        return false;
+    }
+    const size_t limit = getMaxRequestsPerHost(host);
+    return limit > 0 && static_cast<size_t>(hostsInFlight.value(host, 0)) >= limit;
+}
+
+void QGVTilesScheduler::releaseHost(const QString& host)
+{
+    if (host.isEmpty()) {
+        return;
+    }
+    auto it = hostsInFlight.find(host);
+    if (it == hostsInFlight.end()) {
+        return;
+    }
+    if (--it.value() <= 0) {
+        hostsInFlight.erase(it);
+    }
+    for (QGVTilesScheduler* scheduler : schedulers) {
+        if (scheduler->mQueued.isEmpty()) {
+            continue;
+        }
+        QMetaObject::invokeMethod(scheduler->mOwner, scheduler->mDispatcher, Qt::QueuedConnection);
+    }
+}
+
+void QGVTilesScheduler::wakeAll()
+{
+    for (QGVTilesScheduler* scheduler : schedulers) {
+        QMetaObject::invokeMethod(scheduler->mOwner, scheduler->mDispatcher, Qt::QueuedConnection);
+    }
+}
@@ -0,0 +1,326 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTilesSeeder.h"
+#include "QGVTilesFetcher.h"
+#include "QGVTilesStore.h"
+
+#include <QtMath>
+
+namespace {
+const double maxLatitude = 85.05112878;
+const int circuitWaitMs = 1000;
+const int maxSkipsPerPump = 4096;
+const qint64 defaultTileBytes = 16 * 1024;
+
+QGV::GeoPos clampedPos(double lat, double lon)
+{
+    return QGV::GeoPos(qBound(-maxLatitude, lat, maxLatitude), qBound(-180.0, lon, 180.0));
+}
+}
+
+quint64 QGVTilesSeeder::Range::count() const
+{
+    return static_cast<quint64>(right - left + 1) * static_cast<quint64>(bottom - top + 1);
+}
+
+QGVTilesSeeder::QGVTilesSeeder(const QString& storeId, const UrlFactory& urlFactory, QObject* parent)
+    : QObject(parent)
+    , mStoreId(storeId)
+    , mUrlFactory(urlFactory)
+    , mFromZoom(0)
+    , mToZoom(0)
+    , mMaxConcurrency(4)
+    , mRateLimit(8)
+    , mPosition(0)
+    , mRunning(false)
+    , mTokens(0)
+{
+    mPumpTimer.setSingleShot(true);
+    connect(&mPumpTimer, &QTimer::timeout, this, &QGVTilesSeeder::pump);
+}
+
+QGVTilesSeeder::~QGVTilesSeeder()
+{
+    for (const Pending& pending : mPending) {
+        QGVTilesFetcher::globalFetcher()->cancel(pending.ticket);
+    }
+}
+
+void QGVTilesSeeder::setArea(const QGV::GeoRect& area)
+{
+    mArea = area;
+    updateRanges();
+}
+
+QGV::GeoRect QGVTilesSeeder::getArea() const
+{
+    return mArea;
+}
+
+void QGVTilesSeeder::setZoomRange(int fromZoom, int toZoom)
+{
+    mFromZoom = qMax(0, qMin(fromZoom, toZoom));
+    mToZoom = qMin(30, qMax(fromZoom, toZoom));
+    updateRanges();
+}
+
+int QGVTilesSeeder::getFromZoom() const
+{
+    return mFromZoom;
+}
+
+int QGVTilesSeeder::getToZoom() const
+{
+    return mToZoom;
+}
+
+void QGVTilesSeeder::setMaxConcurrency(int value)
+{
+    mMaxConcurrency = qMax(1, value);
+    qgvDebug() << "seeder MaxConcurrency changed to" << mMaxConcurrency;
+}
+
+int QGVTilesSeeder::getMaxConcurrency() const
+{
+    return mMaxConcurrency;
+}
+
+void QGVTilesSeeder::setRateLimit(double tilesPerSecond)
+{
+    mRateLimit = qMax(0.0, tilesPerSecond);
+    qgvDebug() << "seeder RateLimit changed to" << mRateLimit;
+}
+
+double QGVTilesSeeder::getRateLimit() const
+{
+    return mRateLimit;
+}
+
+quint64 QGVTilesSeeder::tilesCount() const
+{
+    quint64 count = 0;
+    for (const Range& range : mRanges) {
+        count += range.count();
+    }
+    return count;
+}
+
+qint64 QGVTilesSeeder::estimatedBytes() const
+{
+    const quint64 known = mProgress.skipped + mProgress.downloaded;
+    const double average = (known > 0 && mProgress.bytes > 0)
+                                   ? static_cast<double>(mProgress.bytes) / static_cast<double>(known)
+                                   : static_cast<double>(defaultTileBytes);
+    return static_cast<qint64>(average * static_cast<double>(tilesCount()));
+}
+
+void QGVTilesSeeder::start(quint64 fromPosition)
+{
+    if (mRunning) {
+        return;
+    }
+    if (QGV::getTilesStore() == nullptr) {
+        qgvCritical() << "seeding requires tiles store";
+        Q_EMIT finished(false);
+        return;
+    }
+    updateRanges();
+    mProgress = {};
+    mProgress.total = tilesCount();
+    mPosition = qMin(fromPosition, mProgress.total);
+    mProgress.processed = mPosition;
+    mTokens = qMin(1.0, mRateLimit);
+    mRefill.start();
+    mRunning = true;
+    qgvDebug() << "seeding" << mStoreId << mProgress.total << "tiles from" << mPosition;
+    pump();
+}
+
+void QGVTilesSeeder::stop()
+{
+    if (!mRunning) {
+        return;
+    }
+    for (const Pending& pending : mPending) {
+        QGVTilesFetcher::globalFetcher()->cancel(pending.ticket);
+    }
+    mPending.clear();
+    finish(false);
+}
+
+bool QGVTilesSeeder::isRunning() const
+{
+    return mRunning;
+}
+
+quint64 QGVTilesSeeder::position() const
+{
+    // Tiles in flight are not done yet, position is safe point to resume from
+    quint64 position = mPosition;
+    for (const Pending& pending : mPending) {
+        position = qMin(position, pending.position);
+    }
+    return position;
+}
+
+QGVTilesSeeder::Progress QGVTilesSeeder::progress() const
+{
+    return mProgress;
+}
+
+void QGVTilesSeeder::updateRanges()
+{
+    mRanges.clear();
+    if (mArea.isEmpty()) {
+        return;
+    }
+    const QGV::GeoPos topLeft = clampedPos(mArea.latTop(), mArea.lonLeft());
+    const QGV::GeoPos bottomRight = clampedPos(mArea.latBottom(), mArea.lonRight());
+    for (int zoom = mFromZoom; zoom <= mToZoom; ++zoom) {
+        const int maxTile = (1 << zoom) - 1;
+        const QPoint first = QGV::GeoTilePos::geoToTilePos(zoom, topLeft).pos();
+        const QPoint last = QGV::GeoTilePos::geoToTilePos(zoom, bottomRight).pos();
+        Range range;
+        range.zoom = zoom;
+        range.left = qBound(0, first.x(), maxTile);
+        range.top = qBound(0, first.y(), maxTile);
+        range.right = qBound(range.left, last.x(), maxTile);
+        range.bottom = qBound(range.top, last.y(), maxTile);
+        mRanges.append(range);
+    }
+}
+
+QGV::GeoTilePos QGVTilesSeeder::tileAt(quint64 position) const
+{
+    for (const Range& range : mRanges) {
+        const quint64 count = range.count();
+        if (position >= count) {
+            position -= count;
+            continue;
+        }
+        const quint64 width = static_cast<quint64>(range.right - range.left + 1);
+        const int x = range.left + static_cast<int>(position % width);
+        const int y = range.top + static_cast<int>(position / width);
+        return QGV::GeoTilePos(range.zoom, QPoint(x, y));
+    }
+    return {};
+}
+
+void QGVTilesSeeder::pump()
+{
+    if (!mRunning) {
+        return;
+    }
+    QGVTilesFetcher* fetcher = QGVTilesFetcher::globalFetcher();
+    if (fetcher->circuitState(mStoreId) == QGVTilesFetcher::CircuitState::Open) {
+        qgvDebug() << "seeding paused by circuit breaker" << mStoreId;
+        schedulePump(circuitWaitMs);
+        return;
+    }
+    const QGVTilesStore* store = QGV::getTilesStore();
+    int skipped = 0;
+    while (mPending.size() < mMaxConcurrency && mPosition < mProgress.total) {
+        const QGV::GeoTilePos tilePos = tileAt(mPosition);
+        const qint64 storedSize = (store != nullptr) ? store->dataSize(mStoreId, tilePos) : -1;
+        if (storedSize >= 0) {
+            mPosition++;
+            mProgress.processed++;
+            mProgress.skipped++;
+            mProgress.bytes += static_cast<quint64>(storedSize);
+            if (++skipped >= maxSkipsPerPump) {
+                break;
+            }
+            continue;
+        }
+        if (!takeToken()) {
+            schedulePump(tokenDelay());
+            break;
+        }
+        QGVTilesFetcher::Request request;
+        request.url = mUrlFactory(tilePos);
+        request.storeId = mStoreId;
+        request.tilePos = tilePos;
+        const quint64 ticket =
+                fetcher->prefetch(request, this, [this, tilePos](bool stored) { onFetched(tilePos, stored); });
+        mPending.insert(tilePos, Pending{ ticket, mPosition });
+        mPosition++;
+    }
+    if (skipped > 0) {
+        Q_EMIT progressChanged(mProgress);
+    }
+    if (skipped >= maxSkipsPerPump) {
+        // Leave event loop some time on long runs of stored tiles
+        schedulePump(0);
+        return;
+    }
+    if (mPosition >= mProgress.total && mPending.isEmpty()) {
+        finish(true);
+    }
+}
+
+void QGVTilesSeeder::schedulePump(int msec)
+{
+    if (!mPumpTimer.isActive()) {
+        mPumpTimer.start(msec);
+    }
+}
+
+bool QGVTilesSeeder::takeToken()
+{
+    if (qFuzzyIsNull(mRateLimit)) {
+        return true;
+    }
+    const double burst = qMax(1.0, qMin(mRateLimit, static_cast<double>(mMaxConcurrency)));
+    mTokens = qMin(burst, mTokens + mRefill.restart() * mRateLimit / 1000.0);
+    if (mTokens < 1.0) {
+        return false;
+    }
+    mTokens -= 1.0;
+    return true;
+}
+
+int QGVTilesSeeder::tokenDelay() const
+{
+    return qMax(1, static_cast<int>(qCeil((1.0 - mTokens) * 1000.0 / mRateLimit)));
+}
+
+void QGVTilesSeeder::onFetched(const QGV::GeoTilePos& tilePos, bool stored)
+{
+    mPending.remove(tilePos);
+    mProgress.processed++;
+    if (!stored) {
+        mProgress.failed++;
+    } else {
+        mProgress.downloaded++;
+        const QGVTilesStore* store = QGV::getTilesStore();
+        const qint64 storedSize = (store != nullptr) ? store->dataSize(mStoreId, tilePos) : -1;
+        mProgress.bytes += static_cast<quint64>(qMax<qint64>(0, storedSize));
+    }
+    Q_EMIT progressChanged(mProgress);
+    pump();
+}
+
+void QGVTilesSeeder::finish(bool completed)
+{
+    mRunning = false;
+    mPumpTimer.stop();
+    qgvDebug() << "seeding" << mStoreId << (completed ? "completed" : "stopped") << "downloaded"
+               << mProgress.downloaded << "skipped" << mProgress.skipped << "failed" << mProgress.failed;
+    Q_EMIT finished(completed);
+}
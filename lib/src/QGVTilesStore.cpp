@@ -0,0 +1,898 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTilesStore.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const quint32 recordMagic = 0x54564751; // "QGVT"
+const quint16 recordVersion = 2;
+const quint16 legacyRecordVersion = 1;
+const quint32 indexMagic = 0x49564751; // "QGVI"
+const quint16 indexVersion = 2;
+const quint16 metadataOnlyFlag = 0x0001;
+
+struct RecordHeader
+{
+    quint32 magic;
+    quint16 version;
+    quint16 layerIdSize;
+    quint64 key;
+    quint32 dataSize;
+    quint16 metaSize; // version 1: always zero, no metadata
+    quint16 flags;    // version 1: always zero
+};
+
+const qint64 headerSize = static_cast<qint64>(sizeof(RecordHeader));
+
+qint64 recordSize(const RecordHeader& header)
+{
+    return headerSize + header.layerIdSize + header.metaSize + header.dataSize;
+}
+
+bool isValidRecord(const RecordHeader& header)
+{
+    return header.magic == recordMagic && (header.version == recordVersion || header.version == legacyRecordVersion);
+}
+
+QByteArray packMetadata(const QGVTilesStore::Metadata& metadata)
+{
+    QByteArray result;
+    QDataStream stream(&result, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << metadata.timestamp << metadata.etag << metadata.lastModified;
+    if (result.size() > 0xffff) {
+        qgvCritical() << "tile metadata is too big, validators dropped";
+        return packMetadata(QGVTilesStore::Metadata{ metadata.timestamp, {}, {} });
+    }
+    return result;
+}
+
+QGVTilesStore::Metadata unpackMetadata(const QByteArray& meta)
+{
+    QGVTilesStore::Metadata metadata;
+    if (meta.isEmpty()) {
+        return metadata;
+    }
+    QDataStream stream(meta);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream >> metadata.timestamp >> metadata.etag >> metadata.lastModified;
+    if (stream.status() != QDataStream::Ok) {
+        return {};
+    }
+    return metadata;
+}
+
+class CompactionTask : public QRunnable
+{
+public:
+    CompactionTask(QGVTilesStore* store, QAtomicInt* queued)
+        : mStore(store)
+        , mQueued(queued)
+    {
+    }
+
+    void run() override
+    {
+        mQueued->storeRelease(0);
+        mStore->compact();
+    }
+
+private:
+    QGVTilesStore* mStore;
+    QAtomicInt* mQueued;
+};
+}
+
+QGVTilesStore::QGVTilesStore(const QString& directory, qint64 maxPackSize)
+    : mDirectory(directory)
+    , mMaxPackSize(maxPackSize)
+    , mMaxSize(0)
+    , mCompactionThreshold(0.5)
+    , mOpen(false)
+    , mCompactionQueued(0)
+{
+    mCompactionPool.setMaxThreadCount(1);
+    open();
+}
+
+QGVTilesStore::~QGVTilesStore()
+{
+    mCompactionPool.clear();
+    mCompactionPool.waitForDone();
+    if (mOpen) {
+        saveIndex();
+    }
+    for (Pack* pack : mPacks) {
+        closePack(pack, false);
+    }
+    mPacks.clear();
+}
+
+QString QGVTilesStore::getDirectory() const
+{
+    return mDirectory;
+}
+
+bool QGVTilesStore::isOpen() const
+{
+    return mOpen;
+}
+
+bool QGVTilesStore::contains(const QString& layerId, const QGV::GeoTilePos& tilePos) const
+{
+    QReadLocker locker(&mLock);
+    return find(layerId, tilePos.toKey()) != nullptr;
+}
+
+qint64 QGVTilesStore::dataSize(const QString& layerId, const QGV::GeoTilePos& tilePos) const
+{
+    QReadLocker locker(&mLock);
+    const Location* location = find(layerId, tilePos.toKey());
+    return (location != nullptr) ? location->size : -1;
+}
+
+QByteArray QGVTilesStore::read(const QString& layerId, const QGV::GeoTilePos& tilePos, Metadata* metadata) const
+{
+    QByteArray data;
+    QByteArray meta;
+    if (!readRecord(layerId, tilePos.toKey(), &data, (metadata != nullptr) ? &meta : nullptr)) {
+        return {};
+    }
+    if (metadata != nullptr) {
+        *metadata = unpackMetadata(meta);
+    }
+    return data;
+}
+
+bool QGVTilesStore::readMetadata(const QString& layerId, const QGV::GeoTilePos& tilePos, Metadata& metadata) const
+{
+    QByteArray meta;
+    if (!readRecord(layerId, tilePos.toKey(), nullptr, &meta)) {
+        return false;
+    }
+    metadata = unpackMetadata(meta);
+    return true;
+}
+
+bool QGVTilesStore::write(const QString& layerId,
+                          const QGV::GeoTilePos& tilePos,
+                          const QByteArray& data,
+                          const Metadata& metadata)
+{
+    if (data.isEmpty()) {
+        return false;
+    }
+    Metadata stamped = metadata;
+    if (stamped.timestamp == 0) {
+        stamped.timestamp = QDateTime::currentMSecsSinceEpoch();
+    }
+    return store(layerId, tilePos.toKey(), packMetadata(stamped), data);
+}
+
+bool QGVTilesStore::updateMetadata(const QString& layerId, const QGV::GeoTilePos& tilePos, const Metadata& metadata)
+{
+    // Records are immutable, metadata-only record is appended which refers to data of existing one
+    Metadata stamped = metadata;
+    if (stamped.timestamp == 0) {
+        stamped.timestamp = QDateTime::currentMSecsSinceEpoch();
+    }
+    const QByteArray meta = packMetadata(stamped);
+    bool needCompaction = false;
+    {
+        QWriteLocker locker(&mLock);
+        if (!mOpen) {
+            return false;
+        }
+        const auto layer = mLayers.constFind(layerId);
+        if (layer == mLayers.constEnd()) {
+            return false;
+        }
+        auto it = mIndex.find(Key(layer.value(), tilePos.toKey()));
+        if (it == mIndex.end()) {
+            return false;
+        }
+        Pack* pack = activePack(headerSize + layerId.toUtf8().size() + meta.size());
+        Location location;
+        if (pack == nullptr || !append(pack, layerId, tilePos.toKey(), meta, {}, metadataOnlyFlag, location)) {
+            return false;
+        }
+        needCompaction = releaseMeta(it.value(), pack);
+        it.value().metaPack = location.metaPack;
+        it.value().metaOffset = location.metaOffset;
+        it.value().metaSize = location.metaSize;
+    }
+    if (needCompaction) {
+        compactInBackground();
+    }
+    return true;
+}
+
+int QGVTilesStore::count() const
+{
+    QReadLocker locker(&mLock);
+    return mIndex.size();
+}
+
+qint64 QGVTilesStore::liveBytes() const
+{
+    QReadLocker locker(&mLock);
+    qint64 result = 0;
+    for (const Pack* pack : mPacks) {
+        result += pack->liveBytes;
+    }
+    return result;
+}
+
+qint64 QGVTilesStore::totalBytes() const
+{
+    QReadLocker locker(&mLock);
+    qint64 result = 0;
+    for (const Pack* pack : mPacks) {
+        result += pack->file->size();
+    }
+    return result;
+}
+
+void QGVTilesStore::setMaxSize(qint64 bytes)
+{
+    mMaxSize = qMax(Q_INT64_C(0), bytes);
+    qgvDebug() << "TilesStore max size changed to" << mMaxSize;
+    compactInBackground();
+}
+
+qint64 QGVTilesStore::getMaxSize() const
+{
+    return mMaxSize;
+}
+
+void QGVTilesStore::setCompactionThreshold(double garbageRatio)
+{
+    mCompactionThreshold = qBound(0.0, garbageRatio, 1.0);
+    qgvDebug() << "TilesStore compaction threshold changed to" << mCompactionThreshold;
+}
+
+double QGVTilesStore::getCompactionThreshold() const
+{
+    return mCompactionThreshold;
+}
+
+void QGVTilesStore::compact()
+{
+    evict();
+    QList<quint32> candidates;
+    {
+        QReadLocker locker(&mLock);
+        if (mPacks.size() < 2) {
+            return;
+        }
+        const quint32 active = mPacks.lastKey();
+        for (const Pack* pack : mPacks) {
+            if (pack->number == active) {
+                continue;
+            }
+            if (pack->liveBytes < pack->file->size() * (1.0 - mCompactionThreshold)) {
+                candidates.append(pack->number);
+            }
+        }
+    }
+    for (quint32 number : candidates) {
+        compactPack(number);
+    }
+}
+
+void QGVTilesStore::compactInBackground()
+{
+    if (!mCompactionQueued.testAndSetAcquire(0, 1)) {
+        return;
+    }
+    mCompactionPool.start(new CompactionTask(this, &mCompactionQueued));
+}
+
+void QGVTilesStore::waitForCompaction()
+{
+    mCompactionPool.waitForDone();
+}
+
+bool QGVTilesStore::store(const QString& layerId, quint64 tileKey, const QByteArray& meta, const QByteArray& data)
+{
+    bool needCompaction = false;
+    {
+        QWriteLocker locker(&mLock);
+        if (!mOpen) {
+            return false;
+        }
+        const QByteArray id = layerId.toUtf8();
+        const int packsBefore = mPacks.size();
+        Pack* pack = activePack(headerSize + id.size() + meta.size() + data.size());
+        // Size is checked only when pack is started, oldest packs are evicted as whole
+        needCompaction = (mMaxSize > 0) && (mPacks.size() != packsBefore);
+        Location location;
+        if (pack == nullptr || !append(pack, layerId, tileKey, meta, data, 0, location)) {
+            return false;
+        }
+        const Key key(layerIndex(layerId), tileKey);
+        auto it = mIndex.find(key);
+        if (it != mIndex.end()) {
+            needCompaction = releaseData(it.value(), pack) || needCompaction;
+            needCompaction = releaseMeta(it.value(), pack) || needCompaction;
+            it.value() = location;
+        } else {
+            mIndex.insert(key, location);
+        }
+    }
+    if (needCompaction) {
+        compactInBackground();
+    }
+    return true;
+}
+
+void QGVTilesStore::open()
+{
+    QWriteLocker locker(&mLock);
+    QDir dir(mDirectory);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qgvCritical() << "unable to create tiles store" << mDirectory;
+        return;
+    }
+    for (const QString& name : dir.entryList({ "*.pack.tmp" }, QDir::Files)) {
+        // Left by interrupted compaction, original pack is still in place
+        dir.remove(name);
+    }
+    QList<quint32> numbers;
+    for (const QString& name : dir.entryList({ "*.pack" }, QDir::Files)) {
+        bool ok = false;
+        const quint32 number = name.section('.', 0, 0).toUInt(&ok);
+        if (ok) {
+            numbers.append(number);
+        }
+    }
+    std::sort(numbers.begin(), numbers.end());
+    const bool indexed = loadIndex(numbers);
+    for (quint32 number : numbers) {
+        openPack(number, !indexed);
+    }
+    if (indexed) {
+        for (auto it = mIndex.begin(); it != mIndex.end();) {
+            Location& location = it.value();
+            Pack* pack = mPacks.value(location.pack, nullptr);
+            if (pack == nullptr) {
+                it = mIndex.erase(it);
+                continue;
+            }
+            Pack* metaPack = mPacks.value(location.metaPack, nullptr);
+            if (metaPack == nullptr) {
+                // Tile stays without metadata, so it is revalidated on next use
+                location.metaPack = location.pack;
+                location.metaOffset = location.offset;
+                location.metaSize = 0;
+                metaPack = pack;
+            }
+            pack->liveBytes += location.size;
+            metaPack->liveBytes += location.metaSize;
+            ++it;
+        }
+    }
+    // Index is valid only until store is changed, it is written again on close
+    QFile::remove(indexPath());
+    mOpen = true;
+    qgvDebug() << "tiles store" << mDirectory << "opened with" << mIndex.size() << "tiles in" << mPacks.size()
+               << "packs" << (indexed ? "from index" : "by scan");
+}
+
+bool QGVTilesStore::loadIndex(const QList<quint32>& numbers)
+{
+    QFile file(indexPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 packCount = 0;
+    stream >> magic >> version >> packCount;
+    if (magic != indexMagic || version != indexVersion || packCount != static_cast<quint32>(numbers.size())) {
+        qgvCritical() << "tiles store index" << file.fileName() << "is outdated";
+        return false;
+    }
+    for (quint32 i = 0; i < packCount; ++i) {
+        quint32 number = 0;
+        qint64 size = 0;
+        stream >> number >> size;
+        if (number != numbers.value(static_cast<int>(i)) || size != QFileInfo(packPath(number)).size()) {
+            qgvCritical() << "tiles store index" << file.fileName() << "is outdated";
+            return false;
+        }
+    }
+    QVector<QString> layers;
+    quint32 count = 0;
+    stream >> layers >> count;
+    QHash<Key, Location> index;
+    index.reserve(static_cast<int>(qMin(count, quint32(1 << 24))));
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Key key;
+        Location location;
+        stream >> key.first >> key.second >> location.pack >> location.size >> location.offset >> location.metaPack
+                >> location.metaOffset >> location.metaSize;
+        index.insert(key, location);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qgvCritical() << "tiles store index" << file.fileName() << "is damaged";
+        return false;
+    }
+    mLayers.clear();
+    for (int i = 0; i < layers.size(); ++i) {
+        mLayers.insert(layers[i], static_cast<quint32>(i));
+    }
+    mIndex = index;
+    return true;
+}
+
+void QGVTilesStore::saveIndex() const
+{
+    QReadLocker locker(&mLock);
+    QSaveFile file(indexPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qgvCritical() << "unable to write tiles store index" << file.fileName() << file.errorString();
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << indexMagic << indexVersion << static_cast<quint32>(mPacks.size());
+    for (const Pack* pack : mPacks) {
+        stream << pack->number << pack->file->size();
+    }
+    QVector<QString> layers(mLayers.size());
+    for (auto it = mLayers.cbegin(); it != mLayers.cend(); ++it) {
+        layers[static_cast<int>(it.value())] = it.key();
+    }
+    stream << layers << static_cast<quint32>(mIndex.size());
+    for (auto it = mIndex.cbegin(); it != mIndex.cend(); ++it) {
+        const Location& location = it.value();
+        stream << it.key().first << it.key().second << location.pack << location.size << location.offset
+               << location.metaPack << location.metaOffset << location.metaSize;
+    }
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qgvCritical() << "unable to write tiles store index" << file.fileName() << file.errorString();
+    }
+}
+
+bool QGVTilesStore::openPack(quint32 number, bool scan)
+{
+    QScopedPointer<QFile> file(new QFile(packPath(number)));
+    if (!file->open(QIODevice::ReadWrite)) {
+        qgvCritical() << "unable to open tiles pack" << file->fileName() << file->errorString();
+        return false;
+    }
+    Pack* pack = new Pack{ number, file.take(), nullptr, 0, 0 };
+    if (!remap(pack)) {
+        // Records can't be read back, leave pack on disk as is
+        qgvCritical() << "tiles pack" << pack->file->fileName() << "skipped";
+        closePack(pack, false);
+        return false;
+    }
+    mPacks.insert(number, pack);
+    if (scan) {
+        scanPack(pack);
+    }
+    return true;
+}
+
+void QGVTilesStore::scanPack(Pack* pack)
+{
+    const qint64 fileSize = pack->file->size();
+    if (pack->mapSize != fileSize) {
+        return;
+    }
+    qint64 offset = 0;
+    while (offset + headerSize <= pack->mapSize) {
+        RecordHeader header;
+        std::memcpy(&header, pack->map + offset, sizeof(header));
+        if (!isValidRecord(header) || offset + recordSize(header) > pack->mapSize) {
+            break;
+        }
+        const QString layerId = QString::fromUtf8(reinterpret_cast<const char*>(pack->map + offset + headerSize),
+                                                  header.layerIdSize);
+        const Key key(layerIndex(layerId), header.key);
+        const qint64 metaOffset = offset + headerSize + header.layerIdSize;
+        const qint64 dataOffset = metaOffset + header.metaSize;
+        auto it = mIndex.find(key);
+        if (header.flags & metadataOnlyFlag) {
+            // Refers to data of tile in previous records, without such tile record is garbage
+            if (it != mIndex.end()) {
+                releaseMeta(it.value(), pack);
+                it.value().metaPack = pack->number;
+                it.value().metaOffset = metaOffset;
+                it.value().metaSize = header.metaSize;
+                pack->liveBytes += header.metaSize;
+            }
+            offset += recordSize(header);
+            continue;
+        }
+        const Location location{ pack->number, header.dataSize, dataOffset, pack->number, metaOffset, header.metaSize };
+        if (it != mIndex.end()) {
+            releaseData(it.value(), pack);
+            releaseMeta(it.value(), pack);
+            it.value() = location;
+        } else {
+            mIndex.insert(key, location);
+        }
+        pack->liveBytes += header.dataSize + header.metaSize;
+        offset += recordSize(header);
+    }
+    if (offset != fileSize) {
+        // Torn write at the tail, drop it so appends start from a valid record
+        qgvCritical() << "tiles pack" << pack->file->fileName() << "truncated from" << fileSize << "to" << offset;
+        if (pack->map != nullptr) {
+            pack->file->unmap(pack->map);
+            pack->map = nullptr;
+            pack->mapSize = 0;
+        }
+        pack->file->resize(offset);
+        remap(pack);
+    }
+}
+
+QGVTilesStore::Pack* QGVTilesStore::activePack(qint64 recordSize)
+{
+    if (!mPacks.isEmpty()) {
+        Pack* last = mPacks.last();
+        if (last->file->size() == 0 || last->file->size() + recordSize <= mMaxPackSize) {
+            return last;
+        }
+    }
+    quint32 number = mPacks.isEmpty() ? 1 : mPacks.lastKey() + 1;
+    while (QFile::exists(packPath(number))) {
+        number++;
+    }
+    if (!openPack(number)) {
+        return nullptr;
+    }
+    return mPacks.value(number);
+}
+
+bool QGVTilesStore::append(Pack* pack,
+                           const QString& layerId,
+                           quint64 tileKey,
+                           const QByteArray& meta,
+                           const QByteArray& data,
+                           quint16 flags,
+                           Location& location)
+{
+    const QByteArray id = layerId.toUtf8();
+    RecordHeader header;
+    header.magic = recordMagic;
+    header.version = recordVersion;
+    header.layerIdSize = static_cast<quint16>(id.size());
+    header.key = tileKey;
+    header.dataSize = static_cast<quint32>(data.size());
+    header.metaSize = static_cast<quint16>(meta.size());
+    header.flags = flags;
+
+    QByteArray record;
+    record.reserve(static_cast<int>(recordSize(header)));
+    record.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    record.append(id);
+    record.append(meta);
+    record.append(data);
+
+    const qint64 offset = pack->file->size();
+    if (!pack->file->seek(offset) || pack->file->write(record) != record.size() || !pack->file->flush()) {
+        qgvCritical() << "unable to write tiles pack" << pack->file->fileName() << pack->file->errorString();
+        pack->file->resize(offset);
+        return false;
+    }
+    const qint64 metaOffset = offset + headerSize + id.size();
+    const qint64 dataOffset = metaOffset + meta.size();
+    location = Location{ pack->number, header.dataSize, dataOffset, pack->number, metaOffset, header.metaSize };
+    pack->liveBytes += data.size() + meta.size();
+    return true;
+}
+
+bool QGVTilesStore::remap(Pack* pack) const
+{
+    const qint64 fileSize = pack->file->size();
+    if (pack->map != nullptr && pack->mapSize == fileSize) {
+        return true;
+    }
+    if (pack->map != nullptr) {
+        pack->file->unmap(pack->map);
+        pack->map = nullptr;
+        pack->mapSize = 0;
+    }
+    if (fileSize == 0) {
+        return true;
+    }
+    pack->map = pack->file->map(0, fileSize);
+    if (pack->map == nullptr) {
+        qgvCritical() << "unable to map tiles pack" << pack->file->fileName() << pack->file->errorString();
+        return false;
+    }
+    pack->mapSize = fileSize;
+    return true;
+}
+
+bool QGVTilesStore::copyData(const Location& location, QByteArray& data) const
+{
+    const Pack* pack = mPacks.value(location.pack, nullptr);
+    if (pack == nullptr || pack->map == nullptr || location.offset + location.size > pack->mapSize) {
+        return false;
+    }
+    data = QByteArray(reinterpret_cast<const char*>(pack->map + location.offset), static_cast<int>(location.size));
+    return true;
+}
+
+bool QGVTilesStore::copyMeta(const Location& location, QByteArray& meta) const
+{
+    const Pack* pack = mPacks.value(location.metaPack, nullptr);
+    if (pack == nullptr || pack->map == nullptr || location.metaOffset + location.metaSize > pack->mapSize) {
+        return false;
+    }
+    meta = QByteArray(reinterpret_cast<const char*>(pack->map + location.metaOffset), location.metaSize);
+    return true;
+}
+
+bool QGVTilesStore::readRecord(const QString& layerId, quint64 tileKey, QByteArray* data, QByteArray* meta) const
+{
+    const auto copy = [this, data, meta](const Location& location) {
+        return (data == nullptr || copyData(location, *data)) && (meta == nullptr || copyMeta(location, *meta));
+    };
+    {
+        QReadLocker locker(&mLock);
+        const Location* location = find(layerId, tileKey);
+        if (location == nullptr) {
+            return false;
+        }
+        if (copy(*location)) {
+            return true;
+        }
+    }
+    QWriteLocker locker(&mLock);
+    const Location* location = find(layerId, tileKey);
+    if (location == nullptr) {
+        return false;
+    }
+    Pack* pack = mPacks.value(location->pack, nullptr);
+    Pack* metaPack = mPacks.value(location->metaPack, nullptr);
+    return pack != nullptr && metaPack != nullptr && remap(pack) && remap(metaPack) && copy(*location);
+}
+
+const QGVTilesStore::Location* QGVTilesStore::find(const QString& layerId, quint64 tileKey) const
+{
+    const auto layer = mLayers.constFind(layerId);
+    if (layer == mLayers.constEnd()) {
+        return nullptr;
+    }
+    const auto location = mIndex.constFind(Key(layer.value(), tileKey));
+    if (location == mIndex.constEnd()) {
+        return nullptr;
+    }
+    return &location.value();
+}
+
+void QGVTilesStore::closePack(Pack* pack, bool remove)
+{
+    if (pack->map != nullptr) {
+        pack->file->unmap(pack->map);
+    }
+    pack->file->close();
+    if (remove) {
+        pack->file->remove();
+    }
+    delete pack->file;
+    delete pack;
+}
+
+void QGVTilesStore::compactPack(quint32 number)
+{
+    // Packs except active one are never written, so live records are copied without lock into new file which
+    // replaces pack under short lock. Records overwritten meanwhile stay in new file as garbage.
+    Pack* pack = nullptr;
+    QHash<qint64, Key> liveData;
+    QHash<qint64, Key> liveMeta;
+    {
+        QWriteLocker locker(&mLock);
+        pack = mPacks.value(number, nullptr);
+        if (pack == nullptr || number == mPacks.lastKey() || !remap(pack)) {
+            return;
+        }
+        for (auto it = mIndex.cbegin(); it != mIndex.cend(); ++it) {
+            if (it.value().pack == number) {
+                liveData.insert(it.value().offset, it.key());
+            }
+            if (it.value().metaPack == number) {
+                liveMeta.insert(it.value().metaOffset, it.key());
+            }
+        }
+        if (liveData.isEmpty() && liveMeta.isEmpty()) {
+            mPacks.remove(number);
+            closePack(pack, true);
+            qgvDebug() << "tiles pack" << number << "removed, no live tiles";
+            return;
+        }
+    }
+    const qint64 before = pack->mapSize;
+    QFile temp(packPath(number) + ".tmp");
+    if (!temp.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qgvCritical() << "unable to compact tiles pack" << pack->file->fileName() << temp.errorString();
+        return;
+    }
+    QMap<qint64, qint64> moved;
+    qint64 offset = 0;
+    while (offset + headerSize <= pack->mapSize) {
+        RecordHeader header;
+        std::memcpy(&header, pack->map + offset, sizeof(header));
+        if (!isValidRecord(header) || offset + recordSize(header) > pack->mapSize) {
+            break;
+        }
+        const qint64 metaOffset = offset + headerSize + header.layerIdSize;
+        const qint64 dataOffset = metaOffset + header.metaSize;
+        const bool dataLive = !(header.flags & metadataOnlyFlag) && liveData.contains(dataOffset);
+        if (dataLive || liveMeta.contains(metaOffset)) {
+            const qint64 newOffset = temp.pos();
+            const qint64 size = recordSize(header);
+            if (temp.write(reinterpret_cast<const char*>(pack->map + offset), size) != size) {
+                qgvCritical() << "compaction of tiles pack" << pack->file->fileName() << "aborted"
+                              << temp.errorString();
+                temp.remove();
+                return;
+            }
+            moved.insert(offset, newOffset);
+        }
+        offset += recordSize(header);
+    }
+    if (!temp.flush()) {
+        qgvCritical() << "compaction of tiles pack" << pack->file->fileName() << "aborted" << temp.errorString();
+        temp.remove();
+        return;
+    }
+    temp.close();
+
+    QWriteLocker locker(&mLock);
+    pack->file->unmap(pack->map);
+    pack->map = nullptr;
+    pack->mapSize = 0;
+    pack->file->close();
+    const QString path = packPath(number);
+    const bool replaced = QFile::remove(path) && temp.rename(path);
+    if (!replaced && QFile::exists(path)) {
+        temp.remove();
+    }
+    if (!QFile::exists(path) || !pack->file->open(QIODevice::ReadWrite) || !remap(pack)) {
+        qgvCritical() << "tiles pack" << path << "lost by compaction";
+        mPacks.remove(number);
+        closePack(pack, false);
+        dropPack(number);
+        return;
+    }
+    if (!replaced) {
+        qgvCritical() << "compaction of tiles pack" << path << "aborted";
+        return;
+    }
+    // Record is moved as whole, so its data and metadata are shifted by the same distance
+    const auto shifted = [&moved](qint64 oldOffset) {
+        auto record = moved.upperBound(oldOffset);
+        --record;
+        return record.value() + oldOffset - record.key();
+    };
+    for (auto it = liveData.cbegin(); it != liveData.cend(); ++it) {
+        auto entry = mIndex.find(it.value());
+        if (entry != mIndex.end() && entry.value().pack == number && entry.value().offset == it.key()) {
+            entry.value().offset = shifted(it.key());
+        }
+    }
+    for (auto it = liveMeta.cbegin(); it != liveMeta.cend(); ++it) {
+        auto entry = mIndex.find(it.value());
+        if (entry != mIndex.end() && entry.value().metaPack == number && entry.value().metaOffset == it.key()) {
+            entry.value().metaOffset = shifted(it.key());
+        }
+    }
+    qgvDebug() << "tiles pack" << number << "compacted from" << before << "to" << pack->mapSize << "bytes";
+}
+
+void QGVTilesStore::evict()
+{
+    if (mMaxSize <= 0) {
+        return;
+    }
+    QWriteLocker locker(&mLock);
+    qint64 total = 0;
+    for (const Pack* pack : mPacks) {
+        total += pack->file->size();
+    }
+    // Oldest packs go first, active pack is never evicted
+    while (total > mMaxSize && mPacks.size() > 1) {
+        Pack* oldest = mPacks.first();
+        const qint64 size = oldest->file->size();
+        total -= size;
+        mPacks.remove(oldest->number);
+        dropPack(oldest->number);
+        qgvDebug() << "tiles pack" << oldest->number << "evicted, released" << size << "bytes";
+        closePack(oldest, true);
+    }
+}
+
+void QGVTilesStore::dropPack(quint32 number)
+{
+    for (auto it = mIndex.begin(); it != mIndex.end();) {
+        Location& location = it.value();
+        if (location.pack == number) {
+            releaseMeta(location, nullptr);
+            it = mIndex.erase(it);
+            continue;
+        }
+        if (location.metaPack == number) {
+            // Tile stays without metadata, so it is revalidated on next use
+            location.metaPack = location.pack;
+            location.metaOffset = location.offset;
+            location.metaSize = 0;
+        }
+        ++it;
+    }
+}
+
+bool QGVTilesStore::releaseData(const Location& location, const Pack* active)
+{
+    return release(location.pack, location.size, active);
+}
+
+bool QGVTilesStore::releaseMeta(const Location& location, const Pack* active)
+{
+    return release(location.metaPack, location.metaSize, active);
+}
+
+bool QGVTilesStore::release(quint32 number, qint64 bytes, const Pack* active)
+{
+    Pack* pack = mPacks.value(number, nullptr);
+    if (pack == nullptr) {
+        return false;
+    }
+    pack->liveBytes -= bytes;
+    return (pack != active) && (pack->liveBytes < pack->file->size() * (1.0 - mCompactionThreshold));
+}
+
+quint32 QGVTilesStore::layerIndex(const QString& layerId)
+{
+    auto it = mLayers.find(layerId);
+    if (it == mLayers.end()) {
+        it = mLayers.insert(layerId, static_cast<quint32>(mLayers.size()));
+    }
+    return it.value();
+}
+
+QString QGVTilesStore::packPath(quint32 number) const
+{
+    return QDir(mDirectory).filePath(QString("%1.pack").arg(number, 8, 10, QChar('0')));
+}
+
+QString QGVTilesStore::indexPath() const
+{
+    return QDir(mDirectory).filePath("index");
+}
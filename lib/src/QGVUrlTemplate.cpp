@@ -0,0 +1,229 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVUrlTemplate.h"
+
+#include <algorithm>
+
+namespace {
+// clang-format off
+const QList<QPair<QString, QGVUrlTemplate::Field>> fieldNames = {
+    { "s", QGVUrlTemplate::Field::Subdomain },
+    { "z", QGVUrlTemplate::Field::Zoom },
+    { "x", QGVUrlTemplate::Field::X },
+    { "y", QGVUrlTemplate::Field::Y },
+    { "-y", QGVUrlTemplate::Field::FlippedY },
+    { "q", QGVUrlTemplate::Field::QuadKey },
+    { "qk", QGVUrlTemplate::Field::QuadKey },
+    { "lcl", QGVUrlTemplate::Field::Locale },
+    { "bbox", QGVUrlTemplate::Field::BBox },
+    { "w", QGVUrlTemplate::Field::Width },
+    { "h", QGVUrlTemplate::Field::Height },
+    { "tilematrixset", QGVUrlTemplate::Field::TileMatrixSet },
+    { "tilematrix", QGVUrlTemplate::Field::TileMatrix },
+    { "tilerow", QGVUrlTemplate::Field::Y },
+    { "tilecol", QGVUrlTemplate::Field::X },
+};
+// clang-format on
+
+const int fieldSizeHint = 12;
+
+void appendNumber(QString& buffer, int value)
+{
+    QChar digits[12];
+    int count = 0;
+    const bool negative = value < 0;
+    quint32 rest = negative ? 0u - static_cast<quint32>(value) : static_cast<quint32>(value);
+    do {
+        digits[count++] = QChar('0' + static_cast<int>(rest % 10));
+        rest /= 10;
+    } while (rest != 0);
+    if (negative) {
+        buffer.append(QChar('-'));
+    }
+    while (count > 0) {
+        buffer.append(digits[--count]);
+    }
+}
+
+void appendQuadKey(QString& buffer, const QGV::GeoTilePos& tilePos)
+{
+    const int x = tilePos.pos().x();
+    const int y = tilePos.pos().y();
+    for (int i = tilePos.zoom(); i > 0; --i) {
+        const int mask = 1 << (i - 1);
+        int digit = 0;
+        if ((x & mask) != 0) {
+            digit += 1;
+        }
+        if ((y & mask) != 0) {
+            digit += 2;
+        }
+        buffer.append(QChar('0' + digit));
+    }
+}
+}
+
+QGVUrlTemplate::QGVUrlTemplate()
+    : mFields(0)
+    , mSizeHint(0)
+{
+}
+
+QGVUrlTemplate::QGVUrlTemplate(const QString& text)
+    : mText(text)
+    , mFields(0)
+    , mSizeHint(0)
+{
+    parse();
+}
+
+QString QGVUrlTemplate::text() const
+{
+    return mText;
+}
+
+bool QGVUrlTemplate::isEmpty() const
+{
+    return mText.isEmpty();
+}
+
+bool QGVUrlTemplate::has(Field field) const
+{
+    return (mFields & (1 << static_cast<int>(field))) != 0;
+}
+
+QString QGVUrlTemplate::format(const Values& values) const
+{
+    QString buffer;
+    format(values, buffer);
+    return buffer;
+}
+
+void QGVUrlTemplate::format(const Values& values, QString& buffer) const
+{
+    if (buffer.capacity() < mSizeHint) {
+        buffer.reserve(mSizeHint);
+    }
+    buffer.resize(0);
+    for (const Segment& segment : mSegments) {
+        append(segment, values, buffer);
+    }
+}
+
+void QGVUrlTemplate::parse()
+{
+    mSegments.clear();
+    mFields = 0;
+    mSizeHint = 0;
+    QString text;
+    int pos = 0;
+    while (pos < mText.size()) {
+        const int open = mText.indexOf('{', pos);
+        const int close = (open < 0) ? -1 : mText.indexOf('}', open + 1);
+        if (open < 0 || close < 0) {
+            text.append(mText.mid(pos));
+            break;
+        }
+        const bool legacy = open > pos && mText.at(open - 1) == '$';
+        const QString name = mText.mid(open + 1, close - open - 1).toLower();
+        auto it = std::find_if(fieldNames.begin(), fieldNames.end(), [&name](const QPair<QString, Field>& item) {
+            return item.first == name;
+        });
+        if (it == fieldNames.end()) {
+            text.append(mText.mid(pos, close + 1 - pos));
+            pos = close + 1;
+            continue;
+        }
+        text.append(mText.mid(pos, open - pos - (legacy ? 1 : 0)));
+        if (!text.isEmpty()) {
+            mSegments.append(Segment{ Field::Text, text });
+            mSizeHint += text.size();
+            text.clear();
+        }
+        mSegments.append(Segment{ it->second, {} });
+        mFields |= 1 << static_cast<int>(it->second);
+        mSizeHint += fieldSizeHint;
+        pos = close + 1;
+    }
+    if (!text.isEmpty()) {
+        mSegments.append(Segment{ Field::Text, text });
+        mSizeHint += text.size();
+    }
+    if (has(Field::BBox)) {
+        mSizeHint += 4 * fieldSizeHint;
+    }
+}
+
+void QGVUrlTemplate::append(const Segment& segment, const Values& values, QString& buffer) const
+{
+    const int zoom = values.tilePos.zoom();
+    const int y = values.tilePos.pos().y();
+    const int flippedY = (1 << zoom) - 1 - y;
+    switch (segment.field) {
+        case Field::Text:
+            buffer.append(segment.text);
+            break;
+        case Field::Subdomain:
+            buffer.append(values.subdomain);
+            break;
+        case Field::Zoom:
+            appendNumber(buffer, zoom);
+            break;
+        case Field::X:
+            appendNumber(buffer, values.tilePos.pos().x());
+            break;
+        case Field::Y:
+            appendNumber(buffer, values.flipY ? flippedY : y);
+            break;
+        case Field::FlippedY:
+            appendNumber(buffer, flippedY);
+            break;
+        case Field::QuadKey:
+            appendQuadKey(buffer, values.tilePos);
+            break;
+        case Field::Locale:
+            buffer.append(values.locale);
+            break;
+        case Field::BBox:
+            buffer.append(QString::number(values.bbox.left(), 'f', 6));
+            buffer.append(QChar(','));
+            buffer.append(QString::number(values.bbox.top(), 'f', 6));
+            buffer.append(QChar(','));
+            buffer.append(QString::number(values.bbox.right(), 'f', 6));
+            buffer.append(QChar(','));
+            buffer.append(QString::number(values.bbox.bottom(), 'f', 6));
+            break;
+        case Field::Width:
+            appendNumber(buffer, values.size.width());
+            break;
+        case Field::Height:
+            appendNumber(buffer, values.size.height());
+            break;
+        case Field::TileMatrixSet:
+            buffer.append(values.tileMatrixSet);
+            break;
+        case Field::TileMatrix:
+            if (zoom < values.tileMatrices.size()) {
+                buffer.append(values.tileMatrices.at(zoom));
+            } else {
+                appendNumber(buffer, zoom);
+            }
+            break;
+    }
+}
@@ -0,0 +1,301 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "Raster/QGVGridCoverage.h"
+
+#include <QtMath>
+
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QGV_GRID_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+const int tileSize = 256;
+const int rampSize = 256;
+const int transparentIndex = rampSize;
+
+struct Mapping
+{
+    float minValue;
+    float scale;
+    float noData;
+    bool hasNoData;
+};
+
+void valuesToIndices(const float* values, qint32* indices, int count, const Mapping& mapping)
+{
+    // index = clamp((value - min) * scale, 0, rampSize - 1), NaN and nodata get transparentIndex
+    int i = 0;
+#ifdef QGV_GRID_SSE2
+    const __m128 minValue = _mm_set1_ps(mapping.minValue);
+    const __m128 scale = _mm_set1_ps(mapping.scale);
+    const __m128 lower = _mm_setzero_ps();
+    const __m128 upper = _mm_set1_ps(static_cast<float>(rampSize - 1));
+    const __m128 noData = _mm_set1_ps(mapping.noData);
+    const __m128i transparent = _mm_set1_epi32(transparentIndex);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 value = _mm_loadu_ps(values + i);
+        const __m128 position = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(value, minValue), scale), lower), upper);
+        __m128 mask = _mm_cmpunord_ps(value, value);
+        if (mapping.hasNoData) {
+            mask = _mm_or_ps(mask, _mm_cmpeq_ps(value, noData));
+        }
+        const __m128i maskBits = _mm_castps_si128(mask);
+        const __m128i index = _mm_or_si128(_mm_andnot_si128(maskBits, _mm_cvttps_epi32(position)),
+                                           _mm_and_si128(maskBits, transparent));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices + i), index);
+    }
+#endif
+    for (; i < count; ++i) {
+        const float value = values[i];
+        if (qIsNaN(value) || (mapping.hasNoData && value == mapping.noData)) {
+            indices[i] = transparentIndex;
+            continue;
+        }
+        const float position = qBound(0.0f, (value - mapping.minValue) * mapping.scale, float(rampSize - 1));
+        indices[i] = static_cast<qint32>(position);
+    }
+}
+
+QImage renderTile(const QVector<float>& values,
+                  const QSize& gridSize,
+                  const QGV::GeoRect& geoRect,
+                  const QVector<quint32>& lookup,
+                  const Mapping& mapping,
+                  const QGV::GeoTilePos& tilePos)
+{
+    const double lonSpan = geoRect.lonRight() - geoRect.lonLeft();
+    const double latSpan = geoRect.latTop() - geoRect.latBottom();
+    const int width = gridSize.width();
+    const int height = gridSize.height();
+    const double worldSize = tileSize * static_cast<double>(1 << tilePos.zoom());
+
+    QVector<int> columns(tileSize);
+    for (int x = 0; x < tileSize; ++x) {
+        const double lon = (tilePos.pos().x() * tileSize + x + 0.5) / worldSize * 360.0 - 180.0;
+        const int column = qFloor((lon - geoRect.lonLeft()) / lonSpan * width);
+        columns[x] = (column >= 0 && column < width) ? column : -1;
+    }
+
+    QImage tile(tileSize, tileSize, QImage::Format_ARGB32_Premultiplied);
+    tile.fill(Qt::transparent);
+    QVector<float> rowValues(tileSize);
+    QVector<qint32> rowIndices(tileSize);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float* grid = values.constData();
+    bool empty = true;
+    for (int y = 0; y < tileSize; ++y) {
+        const double mercator = M_PI * (1.0 - 2.0 * (tilePos.pos().y() * tileSize + y + 0.5) / worldSize);
+        const double lat = qRadiansToDegrees(qAtan(std::sinh(mercator)));
+        const int row = qFloor((geoRect.latTop() - lat) / latSpan * height);
+        if (row < 0 || row >= height) {
+            continue;
+        }
+        const float* source = grid + static_cast<qint64>(row) * width;
+        for (int x = 0; x < tileSize; ++x) {
+            const int column = columns.at(x);
+            rowValues[x] = (column >= 0) ? source[column] : nan;
+        }
+        valuesToIndices(rowValues.constData(), rowIndices.data(), tileSize, mapping);
+        quint32* dest = reinterpret_cast<quint32*>(tile.scanLine(y));
+        for (int x = 0; x < tileSize; ++x) {
+            dest[x] = lookup.at(rowIndices.at(x));
+        }
+        empty = false;
+    }
+    return empty ? QImage() : tile;
+}
+
+QGradientStops defaultRamp()
+{
+    return { { 0.0, QColor(43, 131, 186) },
+             { 0.25, QColor(171, 221, 164) },
+             { 0.5, QColor(255, 255, 191) },
+             { 0.75, QColor(253, 174, 97) },
+             { 1.0, QColor(215, 25, 28) } };
+}
+}
+
+QGVGridCoverage::QGVGridCoverage()
+    : mRamp(defaultRamp())
+    , mMinValue(0)
+    , mMaxValue(1)
+    , mNoData(0)
+    , mHasNoData(false)
+    , mAutoZoom(true)
+    , mMinZoom(0)
+    , mMaxZoom(0)
+{
+    setName("Grid coverage");
+    updateLookup();
+}
+
+void QGVGridCoverage::setGrid(const QVector<float>& values, int width, int height, const QGV::GeoRect& geoRect)
+{
+    if (width <= 0 || height <= 0 || values.size() != width * height) {
+        qgvCritical() << "invalid grid" << width << height << values.size();
+        return;
+    }
+    mValues = values;
+    mGridSize = QSize(width, height);
+    mGeoRect = geoRect;
+
+    float minValue = std::numeric_limits<float>::max();
+    float maxValue = std::numeric_limits<float>::lowest();
+    for (const float value : mValues) {
+        if (qIsNaN(value) || (mHasNoData && value == mNoData)) {
+            continue;
+        }
+        minValue = qMin(minValue, value);
+        maxValue = qMax(maxValue, value);
+    }
+    if (minValue <= maxValue) {
+        mMinValue = minValue;
+        mMaxValue = maxValue;
+    }
+    if (mAutoZoom && geoRect.lonRight() > geoRect.lonLeft()) {
+        // Level where one tile pixel matches one grid cell along longitude
+        const double degreesPerCell = (geoRect.lonRight() - geoRect.lonLeft()) / width;
+        const double native = qLn(360.0 / (tileSize * degreesPerCell)) * M_LOG2E;
+        mMaxZoom = qBound(0, static_cast<int>(qCeil(native)), 22);
+    }
+    qgvDebug() << "grid" << mGridSize << "range" << mMinValue << mMaxValue << "zoom" << mMinZoom << mMaxZoom;
+    reloadTiles();
+}
+
+QVector<float> QGVGridCoverage::getValues() const
+{
+    return mValues;
+}
+
+QSize QGVGridCoverage::getGridSize() const
+{
+    return mGridSize;
+}
+
+QGV::GeoRect QGVGridCoverage::getGeometry() const
+{
+    return mGeoRect;
+}
+
+void QGVGridCoverage::setColorRamp(const QGradientStops& stops)
+{
+    mRamp = stops.isEmpty() ? defaultRamp() : stops;
+    updateLookup();
+    reloadTiles();
+}
+
+QGradientStops QGVGridCoverage::getColorRamp() const
+{
+    return mRamp;
+}
+
+void QGVGridCoverage::setValueRange(float minValue, float maxValue)
+{
+    mMinValue = qMin(minValue, maxValue);
+    mMaxValue = qMax(minValue, maxValue);
+    reloadTiles();
+}
+
+float QGVGridCoverage::getMinValue() const
+{
+    return mMinValue;
+}
+
+float QGVGridCoverage::getMaxValue() const
+{
+    return mMaxValue;
+}
+
+void QGVGridCoverage::setNoDataValue(float value)
+{
+    mNoData = value;
+    mHasNoData = true;
+    reloadTiles();
+}
+
+void QGVGridCoverage::resetNoDataValue()
+{
+    mHasNoData = false;
+    reloadTiles();
+}
+
+void QGVGridCoverage::setZoomLevels(int minZoom, int maxZoom)
+{
+    mAutoZoom = false;
+    mMinZoom = qMax(0, qMin(minZoom, maxZoom));
+    mMaxZoom = qMax(minZoom, maxZoom);
+}
+
+int QGVGridCoverage::minZoomlevel() const
+{
+    return mMinZoom;
+}
+
+int QGVGridCoverage::maxZoomlevel() const
+{
+    return mMaxZoom;
+}
+
+QGVTilesDecoder::Job QGVGridCoverage::tileJob(const QGV::GeoTilePos& tilePos) const
+{
+    if (mValues.isEmpty() || !tilePos.toGeoRect().intersects(mGeoRect)) {
+        return {};
+    }
+    Mapping mapping;
+    mapping.minValue = mMinValue;
+    mapping.scale = (mMaxValue > mMinValue) ? (rampSize - 1) / (mMaxValue - mMinValue) : 0.0f;
+    mapping.noData = mNoData;
+    mapping.hasNoData = mHasNoData;
+    const QVector<float> values = mValues;
+    const QSize gridSize = mGridSize;
+    const QGV::GeoRect geoRect = mGeoRect;
+    const QVector<quint32> lookup = mLookup;
+    return [values, gridSize, geoRect, lookup, mapping, tilePos]() {
+        return renderTile(values, gridSize, geoRect, lookup, mapping, tilePos);
+    };
+}
+
+void QGVGridCoverage::updateLookup()
+{
+    // Last entry is transparent color for NaN and nodata
+    mLookup.resize(rampSize + 1);
+    for (int i = 0; i < rampSize; ++i) {
+        const double position = static_cast<double>(i) / (rampSize - 1);
+        int next = 0;
+        while (next < mRamp.size() - 1 && mRamp.at(next).first < position) {
+            next++;
+        }
+        const int prev = qMax(0, next - 1);
+        const QGradientStop& from = mRamp.at(prev);
+        const QGradientStop& to = mRamp.at(next);
+        const double span = to.first - from.first;
+        const double t = (span > 0) ? qBound(0.0, (position - from.first) / span, 1.0) : 1.0;
+        const QColor& a = from.second;
+        const QColor& b = to.second;
+        const QRgb color = qRgba(qRound(a.red() + (b.red() - a.red()) * t),
+                                 qRound(a.green() + (b.green() - a.green()) * t),
+                                 qRound(a.blue() + (b.blue() - a.blue()) * t),
+                                 qRound(a.alpha() + (b.alpha() - a.alpha()) * t));
+        mLookup[i] = qPremultiply(color);
+    }
+    mLookup[transparentIndex] = 0;
+}
@@ -0,0 +1,241 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "Raster/QGVIconBatch.h"
+#include "QGVMap.h"
+
+namespace {
+const int atlasWidth = 1024;
+const int atlasPadding = 1;
+}
+
+QGVIconBatch::QGVIconBatch()
+    : mAtlasDirty(false)
+    , mVisibleCount(0)
+{
+}
+
+int QGVIconBatch::addSprite(const QImage& image, const QSizeF& size)
+{
+    Sprite sprite;
+    sprite.image = image;
+    sprite.size = !size.isEmpty() ? size : QSizeF(image.size());
+    mSprites.append(sprite);
+    mMaxSpriteSize = mMaxSpriteSize.expandedTo(sprite.size);
+    mAtlasDirty = true;
+    repaint();
+    return mSprites.size() - 1;
+}
+
+int QGVIconBatch::countSprites() const
+{
+    return mSprites.size();
+}
+
+int QGVIconBatch::addIcon(const QGV::GeoPos& geoPos, int sprite)
+{
+    mGeoPos.append(geoPos);
+    mProjPos.append(toProj(geoPos));
+    mSpriteIds.append(sprite);
+    repaint();
+    return mGeoPos.size() - 1;
+}
+
+void QGVIconBatch::setIcons(const QVector<QGV::GeoPos>& positions, const QVector<int>& sprites)
+{
+    Q_ASSERT(positions.size() == sprites.size());
+    mGeoPos = positions;
+    mSpriteIds = sprites;
+    mProjPos.resize(mGeoPos.size());
+    for (int i = 0; i < mGeoPos.size(); ++i) {
+        mProjPos[i] = toProj(mGeoPos.at(i));
+    }
+    repaint();
+}
+
+void QGVIconBatch::setIconPos(int index, const QGV::GeoPos& geoPos)
+{
+    mGeoPos[index] = geoPos;
+    mProjPos[index] = toProj(geoPos);
+    repaint();
+}
+
+void QGVIconBatch::setIconSprite(int index, int sprite)
+{
+    mSpriteIds[index] = sprite;
+    repaint();
+}
+
+QGV::GeoPos QGVIconBatch::getIconPos(int index) const
+{
+    return mGeoPos.at(index);
+}
+
+int QGVIconBatch::getIconSprite(int index) const
+{
+    return mSpriteIds.at(index);
+}
+
+void QGVIconBatch::removeIcon(int index)
+{
+    const int last = mGeoPos.size() - 1;
+    mGeoPos[index] = mGeoPos.at(last);
+    mProjPos[index] = mProjPos.at(last);
+    mSpriteIds[index] = mSpriteIds.at(last);
+    mGeoPos.removeLast();
+    mProjPos.removeLast();
+    mSpriteIds.removeLast();
+    repaint();
+}
+
+int QGVIconBatch::countIcons() const
+{
+    return mGeoPos.size();
+}
+
+void QGVIconBatch::clear()
+{
+    mGeoPos.clear();
+    mProjPos.clear();
+    mSpriteIds.clear();
+    repaint();
+}
+
+void QGVIconBatch::onProjection(QGVMap* geoMap)
+{
+    QGVDrawItem::onProjection(geoMap);
+    for (int i = 0; i < mGeoPos.size(); ++i) {
+        mProjPos[i] = toProj(mGeoPos.at(i));
+    }
+    resetBoundary();
+}
+
+QGraphicsItem::CacheMode QGVIconBatch::projCacheMode() const
+{
+    return QGraphicsItem::NoCache;
+}
+
+QPainterPath QGVIconBatch::projShape() const
+{
+    QPainterPath path;
+    if (getMap() != nullptr) {
+        path.addRect(getMap()->getProjection()->boundaryProjRect());
+    }
+    return path;
+}
+
+void QGVIconBatch::projPaint(QPainter* painter)
+{
+    mVisibleCount = 0;
+    if (mProjPos.isEmpty() || mSprites.isEmpty()) {
+        return;
+    }
+    if (mAtlasDirty) {
+        buildAtlas();
+    }
+
+    // Icons are centered on position, margin keeps partly visible ones
+    const QGVCameraState camera = getMap()->getCamera();
+    const double margin = qMax(mMaxSpriteSize.width(), mMaxSpriteSize.height()) / camera.scale();
+    const QRectF viewRect = camera.projRect().adjusted(-margin, -margin, margin, margin);
+    const QTransform transform = painter->transform();
+
+    mFragments.resize(0);
+    for (int i = 0; i < mProjPos.size(); ++i) {
+        const QPointF& projPos = mProjPos.at(i);
+        if (!viewRect.contains(projPos)) {
+            continue;
+        }
+        const int spriteId = mSpriteIds.at(i);
+        if (spriteId < 0 || spriteId >= mSprites.size()) {
+            continue;
+        }
+        const Sprite& sprite = mSprites.at(spriteId);
+        if (sprite.atlasRect.isEmpty()) {
+            continue;
+        }
+        const QPointF devicePos = transform.map(projPos);
+        mFragments.append(QPainter::PixmapFragment::create(devicePos,
+                                                           QRectF(sprite.atlasRect),
+                                                           sprite.size.width() / sprite.atlasRect.width(),
+                                                           sprite.size.height() / sprite.atlasRect.height()));
+    }
+    mVisibleCount = mFragments.size();
+    if (mFragments.isEmpty()) {
+        return;
+    }
+
+    painter->save();
+    painter->resetTransform();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    painter->drawPixmapFragments(mFragments.constData(), mFragments.size(), mAtlas);
+    painter->restore();
+}
+
+QString QGVIconBatch::projDebug()
+{
+    return QString("icon batch\nicons %1, visible %2\nsprites %3, atlas %4x%5")
+            .arg(mGeoPos.size())
+            .arg(mVisibleCount)
+            .arg(mSprites.size())
+            .arg(mAtlas.width())
+            .arg(mAtlas.height());
+}
+
+void QGVIconBatch::buildAtlas()
+{
+    // Shelf packing, sprites are placed left to right in rows of height of highest sprite in row
+    int width = atlasWidth;
+    for (const Sprite& sprite : mSprites) {
+        width = qMax(width, sprite.image.width() + 2 * atlasPadding);
+    }
+    int x = 0;
+    int y = 0;
+    int rowHeight = 0;
+    for (Sprite& sprite : mSprites) {
+        const QSize size = sprite.image.size() + QSize(2 * atlasPadding, 2 * atlasPadding);
+        if (x + size.width() > width) {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        sprite.atlasRect = QRect(QPoint(x + atlasPadding, y + atlasPadding), sprite.image.size());
+        x += size.width();
+        rowHeight = qMax(rowHeight, size.height());
+    }
+
+    QImage atlas(width, qMax(1, y + rowHeight), QImage::Format_ARGB32_Premultiplied);
+    atlas.fill(Qt::transparent);
+    QPainter painter(&atlas);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (const Sprite& sprite : mSprites) {
+        painter.drawImage(sprite.atlasRect.topLeft(), sprite.image);
+    }
+    painter.end();
+    mAtlas = QPixmap::fromImage(atlas);
+    mAtlasDirty = false;
+    qgvDebug() << "icon atlas" << mAtlas.size() << "sprites" << mSprites.size();
+}
+
+QPointF QGVIconBatch::toProj(const QGV::GeoPos& geoPos) const
+{
+    if (getMap() == nullptr) {
+        return {};
+    }
+    return getMap()->getProjection()->geoToProj(geoPos);
+}
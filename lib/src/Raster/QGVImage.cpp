@@ -18,11 +18,51 @@
 
 #include "Raster/QGVImage.h"
 #include "QGVMap.h"
+#include "QGVTilesDecoder.h"
 
+#include <QBuffer>
+#include <QImageReader>
 #include <QPainter>
+#include <QtMath>
+
+namespace {
+const int bucketsPerOctave = 4;
+const int maxScaledSide = 4096;
+const int minPreviewSide = 64;
+const int maxPreviewSide = 1024;
+const int defaultPreviewSide = 512;
+const int detailDelayMs = 150;
+
+QImage readImage(const QByteArray& rawData, const QString& fileName, const QRect& clipRect, const QSize& scaledSize)
+{
+    QBuffer buffer;
+    QImageReader reader;
+    if (!fileName.isEmpty()) {
+        reader.setFileName(fileName);
+    } else {
+        buffer.setData(rawData);
+        reader.setDevice(&buffer);
+    }
+    if (!clipRect.isEmpty()) {
+        reader.setClipRect(clipRect);
+    }
+    if (!scaledSize.isEmpty()) {
+        reader.setScaledSize(scaledSize);
+    }
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        qgvDebug() << "unable to decode image" << fileName << reader.errorString();
+    }
+    return image;
+}
+}
 
 QGVImage::QGVImage()
-    : mCeilingOnScale{ true }
+    : mGeneration{ 0 }
+    , mDetailRequest{ 0 }
+    , mDetailTimer{ nullptr }
+    , mLoading{ false }
+    , mCeilingOnScale{ true }
 {
 }
 
@@ -59,21 +99,76 @@ void QGVImage::loadImage(const QByteArray& rawData)
 
 void QGVImage::loadImage(const QImage& image)
 {
+    mGeneration++;
+    if (mDetailTimer != nullptr) {
+        mLatestDetail->storeRelease(++mDetailRequest);
+        mDetailTimer->stop();
+    }
+    mSourceData.clear();
+    mSourceFile.clear();
+    mSourceSize = {};
+    mLoading = false;
+    mDetailProjRect = {};
+    mRequestedProjRect = {};
     mImage = image;
+    resetPixmaps();
     calculateGeometry();
 }
 
+void QGVImage::loadImageAsync(const QByteArray& rawData)
+{
+    loadImage(QImage());
+    mSourceData = rawData;
+    initDetail();
+    startProgressive();
+}
+
+void QGVImage::loadImageAsync(const QString& fileName)
+{
+    loadImage(QImage());
+    mSourceFile = fileName;
+    initDetail();
+    startProgressive();
+}
+
+bool QGVImage::isLoading() const
+{
+    return mLoading;
+}
+
 void QGVImage::setCeilingOnScale(bool enabled)
 {
     mCeilingOnScale = enabled;
 }
 
+void QGVImage::releasePixmaps()
+{
+    mPixmap = {};
+    mScaled = {};
+    mDetailScaled = {};
+}
+
 void QGVImage::onProjection(QGVMap* geoMap)
 {
     QGVDrawItem::onProjection(geoMap);
     calculateGeometry();
 }
 
+void QGVImage::onCamera(const QGVCameraState& oldState, const QGVCameraState& newState)
+{
+    QGVDrawItem::onCamera(oldState, newState);
+    if (mDetailTimer != nullptr && !mSourceSize.isEmpty() && !newState.animation()) {
+        // Camera moves in many small steps, region is chosen when it stops
+        mDetailTimer->start();
+    }
+}
+
+QGraphicsItem::CacheMode QGVImage::projCacheMode() const
+{
+    // Own scaled pixmap survives zoom changes, device cache of scene would only duplicate it
+    return QGraphicsItem::NoCache;
+}
+
 QPainterPath QGVImage::projShape() const
 {
     QPainterPath path;
@@ -94,8 +189,37 @@ void QGVImage::projPaint(QPainter* painter)
         paintRect.setSize(paintRect.size() + QSizeF(pixelFactor, pixelFactor));
     }
 
-    painter->setRenderHint(QPainter::SmoothPixmapTransform);
-    painter->drawImage(paintRect, getImage());
+    if (mPixmap.isNull()) {
+        mPixmap = QPixmap::fromImage(mImage);
+    }
+    paintPixmap(painter, paintRect, mPixmap, mScaled);
+
+    if (!mDetail.isNull()) {
+        paintPixmap(painter, mDetailProjRect, mDetail, mDetailScaled);
+    }
+}
+
+void QGVImage::paintPixmap(QPainter* painter, const QRectF& paintRect, const QPixmap& source, Scaled& scaled)
+{
+    const QTransform transform = painter->transform();
+    if (transform.type() > QTransform::TxScale || transform.m11() <= 0 || transform.m22() <= 0) {
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        painter->drawPixmap(paintRect, source, QRectF(source.rect()));
+        return;
+    }
+
+    const QRect deviceRect = transform.mapRect(paintRect).toAlignedRect();
+    const qreal pixelRatio = painter->device()->devicePixelRatioF();
+    const QPixmap& pixmap = scaledPixmap(source, scaled, deviceRect.size(), pixelRatio);
+    painter->save();
+    painter->resetTransform();
+    if (pixmap.size() == deviceRect.size() * pixelRatio) {
+        painter->drawPixmap(deviceRect.topLeft(), pixmap);
+    } else {
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        painter->drawPixmap(QRectF(deviceRect), pixmap, QRectF(pixmap.rect()));
+    }
+    painter->restore();
 }
 
 void QGVImage::calculateGeometry()
@@ -111,3 +235,207 @@ void QGVImage::calculateGeometry()
     resetBoundary();
     refresh();
 }
+
+const QPixmap& QGVImage::scaledPixmap(const QPixmap& pixmap, Scaled& scaled, const QSize& deviceSize, qreal pixelRatio)
+{
+    const QSize pixelSize = deviceSize * pixelRatio;
+    if (deviceSize.isEmpty() || pixelSize.width() > maxScaledSide || pixelSize.height() > maxScaledSide) {
+        return pixmap;
+    }
+    if (pixelSize == pixmap.size() && qFuzzyCompare(pixelRatio, 1.0)) {
+        return pixmap;
+    }
+    const double ratio = static_cast<double>(pixelSize.width()) / pixmap.width();
+    const int bucket = qRound(qLn(ratio) * M_LOG2E * bucketsPerOctave);
+    // Size which stays same between paints means scale has settled and exact copy is worth building
+    const bool settled = (deviceSize == scaled.lastDeviceSize);
+    scaled.lastDeviceSize = deviceSize;
+    if (scaled.pixmap.isNull() || bucket != scaled.bucket || (settled && scaled.pixmap.size() != pixelSize)) {
+        scaled.pixmap = pixmap.scaled(pixelSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        scaled.pixmap.setDevicePixelRatio(pixelRatio);
+        scaled.bucket = bucket;
+    }
+    return scaled.pixmap;
+}
+
+void QGVImage::resetPixmaps()
+{
+    mPixmap = {};
+    mScaled = {};
+    mDetail = {};
+    mDetailScaled = {};
+}
+
+void QGVImage::initDetail()
+{
+    // Most images are loaded synchronously (e.g. tiles), only progressive loading needs these
+    if (mDetailTimer != nullptr) {
+        return;
+    }
+    mLatestDetail.reset(new QAtomicInteger<quint64>(mDetailRequest));
+    mDetailTimer = new QTimer(this);
+    mDetailTimer->setSingleShot(true);
+    mDetailTimer->setInterval(detailDelayMs);
+    connect(mDetailTimer, &QTimer::timeout, this, &QGVImage::onDetailTimer);
+}
+
+void QGVImage::startProgressive()
+{
+    QBuffer buffer;
+    QImageReader reader;
+    if (!mSourceFile.isEmpty()) {
+        reader.setFileName(mSourceFile);
+    } else {
+        buffer.setData(mSourceData);
+        reader.setDevice(&buffer);
+    }
+    // Only header is read here, size is needed to choose preview and regions
+    mSourceSize = reader.size();
+    if (mSourceSize.isEmpty()) {
+        qgvCritical() << "unable to read image" << mSourceFile << reader.errorString();
+        return;
+    }
+    mLoading = true;
+    requestPreview();
+}
+
+void QGVImage::requestPreview()
+{
+    int side = defaultPreviewSide;
+    if (getMap() != nullptr && !mProjRect.isEmpty()) {
+        const double scale = getMap()->getCamera().scale();
+        side = qRound(qMax(mProjRect.width(), mProjRect.height()) * scale);
+    }
+    side = qBound(minPreviewSide, side, maxPreviewSide);
+    QSize previewSize = mSourceSize;
+    if (previewSize.width() > side || previewSize.height() > side) {
+        previewSize.scale(side, side, Qt::KeepAspectRatio);
+    }
+    previewSize = previewSize.expandedTo(QSize(1, 1));
+
+    const QByteArray rawData = mSourceData;
+    const QString fileName = mSourceFile;
+    const quint64 generation = mGeneration;
+    QGVTilesDecoder::globalDecoder()->run(
+            [rawData, fileName, previewSize]() { return readImage(rawData, fileName, QRect(), previewSize); },
+            this,
+            [this, generation](const QImage& image) { onPreview(generation, image); });
+    qgvDebug() << "image preview" << previewSize << "of" << mSourceSize;
+}
+
+void QGVImage::onDetailTimer()
+{
+    if (getMap() == nullptr) {
+        return;
+    }
+    if (getMap()->getState() != QGV::MapState::Idle || getMap()->getCamera().animation()) {
+        mDetailTimer->start();
+        return;
+    }
+    requestDetail();
+}
+
+void QGVImage::requestDetail()
+{
+    if (mImage.isNull() || getMap() == nullptr || mProjRect.isEmpty()) {
+        return;
+    }
+    const QGVCameraState camera = getMap()->getCamera();
+    const QRectF visible = camera.projRect().intersected(mProjRect);
+    if (visible.isEmpty()) {
+        return;
+    }
+    // Resolutions in pixels per projection unit
+    const double sourceScaleX = mSourceSize.width() / mProjRect.width();
+    const double sourceScaleY = mSourceSize.height() / mProjRect.height();
+    const double needed = qMin(camera.scale(), sourceScaleX);
+    const double current = mImage.width() / mProjRect.width();
+    if (current >= needed * 0.9) {
+        return;
+    }
+    if (!mDetail.isNull() && mDetailProjRect.contains(visible) &&
+        mDetail.width() / mDetailProjRect.width() >= needed * 0.9) {
+        return;
+    }
+    if (mRequestedProjRect.contains(visible)) {
+        return;
+    }
+
+    const QRect sourceRect(QPoint(0, 0), mSourceSize);
+    const QRect clip = QRectF((visible.left() - mProjRect.left()) * sourceScaleX,
+                              (visible.top() - mProjRect.top()) * sourceScaleY,
+                              visible.width() * sourceScaleX,
+                              visible.height() * sourceScaleY)
+                               .toAlignedRect() &
+                       sourceRect;
+    if (clip.isEmpty()) {
+        return;
+    }
+    const double factor = qMin(1.0, needed / sourceScaleX);
+    const QSize targetSize(qMax(1, qRound(clip.width() * factor)), qMax(1, qRound(clip.height() * factor)));
+    const QRectF projRect(mProjRect.left() + clip.x() / sourceScaleX,
+                          mProjRect.top() + clip.y() / sourceScaleY,
+                          clip.width() / sourceScaleX,
+                          clip.height() / sourceScaleY);
+    // Whole image at full resolution replaces preview instead of being a region on top of it
+    const bool full = (clip == sourceRect && targetSize == mSourceSize);
+
+    const QByteArray rawData = mSourceData;
+    const QString fileName = mSourceFile;
+    const quint64 generation = mGeneration;
+    const quint64 request = ++mDetailRequest;
+    const QSharedPointer<QAtomicInteger<quint64>> latest = mLatestDetail;
+    const QRect clipRect = full ? QRect() : clip;
+    latest->storeRelease(request);
+    mRequestedProjRect = projRect;
+    mLoading = true;
+    QGVTilesDecoder::globalDecoder()->run(
+            [rawData, fileName, clipRect, targetSize, latest, request]() {
+                if (latest->loadAcquire() != request) {
+                    return QImage();
+                }
+                return readImage(rawData, fileName, clipRect, targetSize);
+            },
+            this,
+            [this, generation, request, projRect, full](const QImage& image) {
+                onDetail(generation, request, image, projRect, full);
+            });
+    qgvDebug() << "image region" << clip << "as" << targetSize;
+}
+
+void QGVImage::onPreview(quint64 generation, const QImage& image)
+{
+    if (generation != mGeneration) {
+        return;
+    }
+    mLoading = false;
+    if (image.isNull()) {
+        return;
+    }
+    mImage = image;
+    resetPixmaps();
+    calculateGeometry();
+    requestDetail();
+}
+
+void QGVImage::onDetail(quint64 generation, quint64 request, const QImage& image, const QRectF& projRect, bool full)
+{
+    if (generation != mGeneration || request != mDetailRequest) {
+        return;
+    }
+    mLoading = false;
+    mRequestedProjRect = {};
+    if (image.isNull()) {
+        return;
+    }
+    if (full) {
+        mImage = image;
+        resetPixmaps();
+        mDetailProjRect = {};
+    } else {
+        mDetail = QPixmap::fromImage(image);
+        mDetailScaled = {};
+        mDetailProjRect = projRect;
+    }
+    repaint();
+}
@@ -0,0 +1,416 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "Raster/QGVImageTiles.h"
+#include "QGVTilesStore.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QPainter>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QtMath>
+
+namespace {
+const int tileSize = 256;
+const double maxLatitude = 85.05112878;
+const QGV::GeoTilePos levelsMarker(31, QPoint(0, 0));
+
+QGVTilesDecoder* overviewsBuilder()
+{
+    // Building takes long, it must not occupy threads of global decoder which serve all tile layers
+    static QGVTilesDecoder builder;
+    builder.setMaxThreadCount(1);
+    return &builder;
+}
+
+QPointF geoToWorld(double lat, double lon)
+{
+    const double rad = qDegreesToRadians(qBound(-maxLatitude, lat, maxLatitude));
+    const double x = (lon + 180.0) / 360.0;
+    const double y = (1.0 - qLn(qTan(rad) + 1.0 / qCos(rad)) / M_PI) / 2.0;
+    return QPointF(x, y);
+}
+}
+
+/*!
+ * Image file shared by tile jobs of one layer, safe for use from several worker threads.
+ * Without clip and scaled reads tiles come from chunks of overviews in tiles store, they are cut once by build().
+ */
+class QGVImageTilesSource
+{
+public:
+    explicit QGVImageTilesSource(const QString& fileName)
+        : mFileName(fileName)
+        , mRegionReads(false)
+        , mClipReads(false)
+        , mStore(QGV::getTilesStore())
+        , mLevels(0)
+        , mCanceled(0)
+    {
+        QImageReader reader(fileName);
+        mSize = reader.size();
+        mClipReads = reader.supportsOption(QImageIOHandler::ClipRect);
+        mRegionReads = mClipReads && reader.supportsOption(QImageIOHandler::ScaledSize);
+        if (!mSize.isValid()) {
+            qgvCritical() << "unable to read image" << fileName << reader.errorString();
+        }
+        const QFileInfo info(fileName);
+        mStoreId = QString("image:%1:%2:%3")
+                           .arg(info.absoluteFilePath())
+                           .arg(info.size())
+                           .arg(info.lastModified().toMSecsSinceEpoch());
+        if (!mRegionReads && mStore == nullptr) {
+            // Chunks need some place, private store lives as long as this source
+            mTempDir.reset(new QTemporaryDir());
+            mOwnStore.reset(new QGVTilesStore(mTempDir->path()));
+            mStore = mOwnStore.data();
+        }
+    }
+
+    QString fileName() const
+    {
+        return mFileName;
+    }
+
+    QSize size() const
+    {
+        return mSize;
+    }
+
+    bool isRegionReads() const
+    {
+        return mRegionReads;
+    }
+
+    bool isClipReads() const
+    {
+        return mClipReads;
+    }
+
+    bool isBuilt() const
+    {
+        return mLevels.loadAcquire() > 0;
+    }
+
+    void cancel()
+    {
+        mCanceled.storeRelease(1);
+    }
+
+    QImage read(const QRect& region, const QSize& targetSize)
+    {
+        if (mRegionReads) {
+            QImageReader reader(mFileName);
+            reader.setClipRect(region);
+            reader.setScaledSize(targetSize);
+            return reader.read();
+        }
+        const int levels = mLevels.loadAcquire();
+        if (levels == 0) {
+            // Overviews are not built yet, layer requests failed tiles again when they are
+            return {};
+        }
+        // Finest overview which is still not smaller than target
+        const double factor = static_cast<double>(region.width()) / targetSize.width();
+        const int level = qBound(0, static_cast<int>(qFloor(qLn(qMax(1.0, factor)) * M_LOG2E)), levels - 1);
+        const double levelScale = 1.0 / (1 << level);
+        const QRect rect = QRectF(region.x() * levelScale,
+                                  region.y() * levelScale,
+                                  region.width() * levelScale,
+                                  region.height() * levelScale)
+                                   .toAlignedRect();
+        QImage part(rect.size(), QImage::Format_ARGB32_Premultiplied);
+        part.fill(Qt::transparent);
+        QPainter painter(&part);
+        for (int y = rect.top() / tileSize; y <= rect.bottom() / tileSize; ++y) {
+            for (int x = rect.left() / tileSize; x <= rect.right() / tileSize; ++x) {
+                painter.drawImage(QPoint(x, y) * tileSize - rect.topLeft(), chunk(level, x, y));
+            }
+        }
+        painter.end();
+        return part.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    void build()
+    {
+        const QByteArray marker = mStore->read(mStoreId, levelsMarker);
+        if (!marker.isEmpty()) {
+            mLevels.storeRelease(marker.toInt());
+            return;
+        }
+        qgvDebug() << "build overviews" << mFileName << mSize << (mClipReads ? "by clip reads" : "by full decode");
+        if (!(mClipReads ? cutByClipReads() : cutByFullDecode())) {
+            return;
+        }
+        int level = 0;
+        QSize levelSize = mSize;
+        while (levelSize.width() > tileSize || levelSize.height() > tileSize) {
+            levelSize = QSize((levelSize.width() + 1) / 2, (levelSize.height() + 1) / 2);
+            if (!cutLevel(level + 1, levelSize)) {
+                return;
+            }
+            level++;
+        }
+        mStore->write(mStoreId, levelsMarker, QByteArray::number(level + 1));
+        mLevels.storeRelease(level + 1);
+        qgvDebug() << "overviews built" << mFileName << level + 1 << "levels";
+    }
+
+private:
+    QImage chunk(int level, int x, int y) const
+    {
+        return QGVTilesDecoder::decodeImage(mStore->read(mStoreId, QGV::GeoTilePos(level, QPoint(x, y))));
+    }
+
+    bool writeChunk(int level, int x, int y, const QImage& image)
+    {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "PNG");
+        return mStore->write(mStoreId, QGV::GeoTilePos(level, QPoint(x, y)), data);
+    }
+
+    bool cutRow(const QImage& strip, int y)
+    {
+        for (int x = 0; x * tileSize < strip.width(); ++x) {
+            if (mCanceled.loadAcquire() != 0 || !writeChunk(0, x, y, strip.copy(x * tileSize, 0, tileSize, tileSize))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool cutByClipReads()
+    {
+        // Only one row of chunks is decoded at a time
+        for (int y = 0; y * tileSize < mSize.height(); ++y) {
+            QImageReader reader(mFileName);
+            reader.setClipRect(QRect(0, y * tileSize, mSize.width(), tileSize) & QRect(QPoint(0, 0), mSize));
+            const QImage strip = reader.read();
+            if (strip.isNull()) {
+                qgvCritical() << "unable to decode image" << mFileName << reader.errorString();
+                return false;
+            }
+            if (!cutRow(strip.convertToFormat(QImage::Format_ARGB32_Premultiplied), y)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool cutByFullDecode()
+    {
+        // Whole image is decoded once (e.g. TIFF), it is released as soon as chunks of finest level are stored
+        QImageReader reader(mFileName);
+        QImage image = reader.read();
+        if (image.isNull()) {
+            qgvCritical() << "unable to decode image" << mFileName << reader.errorString();
+            return false;
+        }
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        for (int y = 0; y * tileSize < image.height(); ++y) {
+            if (!cutRow(image.copy(0, y * tileSize, image.width(), tileSize), y)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool cutLevel(int level, const QSize& levelSize)
+    {
+        // Every chunk is made of four chunks of finer level
+        for (int y = 0; y * tileSize < levelSize.height(); ++y) {
+            for (int x = 0; x * tileSize < levelSize.width(); ++x) {
+                if (mCanceled.loadAcquire() != 0) {
+                    return false;
+                }
+                QImage quad(tileSize * 2, tileSize * 2, QImage::Format_ARGB32_Premultiplied);
+                quad.fill(Qt::transparent);
+                QPainter painter(&quad);
+                for (int dy = 0; dy < 2; ++dy) {
+                    for (int dx = 0; dx < 2; ++dx) {
+                        painter.drawImage(dx * tileSize, dy * tileSize, chunk(level - 1, x * 2 + dx, y * 2 + dy));
+                    }
+                }
+                painter.end();
+                const QImage scaled = quad.scaled(tileSize, tileSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                if (!writeChunk(level, x, y, scaled)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    const QString mFileName;
+    QSize mSize;
+    bool mRegionReads;
+    bool mClipReads;
+    QScopedPointer<QTemporaryDir> mTempDir;
+    QScopedPointer<QGVTilesStore> mOwnStore;
+    QGVTilesStore* mStore;
+    QString mStoreId;
+    QAtomicInt mLevels;
+    QAtomicInt mCanceled;
+};
+
+QGVImageTiles::QGVImageTiles(const QString& fileName, const QGV::GeoRect& geoRect)
+    : mSource(new QGVImageTilesSource(fileName))
+    , mGeoRect(geoRect)
+    , mMinZoom(0)
+    , mMaxZoom(0)
+{
+    setName(QFileInfo(fileName).fileName());
+    setDescription(fileName);
+
+    const QPointF topLeft = geoToWorld(geoRect.latTop(), geoRect.lonLeft());
+    const QPointF bottomRight = geoToWorld(geoRect.latBottom(), geoRect.lonRight());
+    mWorldRect = QRectF(topLeft, bottomRight).normalized();
+    if (isValid() && mWorldRect.width() > 0) {
+        // Level where one tile pixel matches one image pixel
+        const double native = qLn(mSource->size().width() / (mWorldRect.width() * tileSize)) * M_LOG2E;
+        mMaxZoom = qBound(0, static_cast<int>(qCeil(native)), 22);
+    }
+    qgvDebug() << "image tiles" << fileName << mSource->size() << "zoom" << mMinZoom << mMaxZoom
+               << (isRegionReads() ? "region reads" : "overviews");
+    if (isValid() && !isRegionReads()) {
+        const QSharedPointer<QGVImageTilesSource> imageSource = mSource;
+        overviewsBuilder()->run(
+                [imageSource]() {
+                    imageSource->build();
+                    return QImage();
+                },
+                this,
+                [this](const QImage&) { onOverviewsBuilt(); });
+    }
+}
+
+QGVImageTiles::~QGVImageTiles()
+{
+    mSource->cancel();
+}
+
+QString QGVImageTiles::getFileName() const
+{
+    return mSource->fileName();
+}
+
+QGV::GeoRect QGVImageTiles::getGeometry() const
+{
+    return mGeoRect;
+}
+
+QSize QGVImageTiles::getImageSize() const
+{
+    return mSource->size();
+}
+
+bool QGVImageTiles::isValid() const
+{
+    return !mSource->size().isEmpty();
+}
+
+bool QGVImageTiles::isRegionReads() const
+{
+    return mSource->isRegionReads();
+}
+
+bool QGVImageTiles::isReady() const
+{
+    return isValid() && (isRegionReads() || mSource->isBuilt());
+}
+
+void QGVImageTiles::setZoomLevels(int minZoom, int maxZoom)
+{
+    mMinZoom = qMax(0, qMin(minZoom, maxZoom));
+    mMaxZoom = qMax(minZoom, maxZoom);
+}
+
+int QGVImageTiles::minZoomlevel() const
+{
+    return mMinZoom;
+}
+
+int QGVImageTiles::maxZoomlevel() const
+{
+    return mMaxZoom;
+}
+
+void QGVImageTiles::onOverviewsBuilt()
+{
+    if (!mSource->isBuilt()) {
+        qgvCritical() << "overviews of" << getFileName() << "are not built";
+        return;
+    }
+    retryFailedTiles();
+}
+
+QGVTilesDecoder::Job QGVImageTiles::tileJob(const QGV::GeoTilePos& tilePos) const
+{
+    if (!isValid()) {
+        return {};
+    }
+    const double tileWorld = 1.0 / (1 << tilePos.zoom());
+    const QRectF tileRect(tilePos.pos().x() * tileWorld, tilePos.pos().y() * tileWorld, tileWorld, tileWorld);
+    if (!tileRect.intersects(mWorldRect)) {
+        return {};
+    }
+    // Region of image covered by tile, in image pixels
+    const QSize imageSize = mSource->size();
+    const double scaleX = imageSize.width() / mWorldRect.width();
+    const double scaleY = imageSize.height() / mWorldRect.height();
+    const QRectF source((tileRect.x() - mWorldRect.x()) * scaleX,
+                        (tileRect.y() - mWorldRect.y()) * scaleY,
+                        tileRect.width() * scaleX,
+                        tileRect.height() * scaleY);
+    const QRect region = source.toAlignedRect() & QRect(QPoint(0, 0), imageSize);
+    if (region.isEmpty()) {
+        return {};
+    }
+    // Place of region inside tile, in tile pixels
+    const double tileScaleX = tileSize / source.width();
+    const double tileScaleY = tileSize / source.height();
+    const QRectF target((region.x() - source.x()) * tileScaleX,
+                        (region.y() - source.y()) * tileScaleY,
+                        region.width() * tileScaleX,
+                        region.height() * tileScaleY);
+    const QSize targetSize(qMax(1, qRound(target.width())), qMax(1, qRound(target.height())));
+
+    const QSharedPointer<QGVImageTilesSource> imageSource = mSource;
+    return [imageSource, region, target, targetSize]() {
+        const QImage part = imageSource->read(region, targetSize);
+        if (part.isNull()) {
+            return QImage();
+        }
+        if (part.size() == QSize(tileSize, tileSize) && target.topLeft().toPoint().isNull()) {
+            return part;
+        }
+        QImage tile(tileSize, tileSize, QImage::Format_ARGB32_Premultiplied);
+        tile.fill(Qt::transparent);
+        QPainter painter(&tile);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawImage(target, part);
+        painter.end();
+        return tile;
+    };
+}
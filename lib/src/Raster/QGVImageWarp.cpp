@@ -0,0 +1,183 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "Raster/QGVImageWarp.h"
+
+#include <QtMath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QGV_WARP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+const int tileSize = 256;
+
+void blendRows(const quint32* row0, const quint32* row1, quint32* dest, int count, int weight)
+{
+    // dest = (row0 * (256 - weight) + row1 * weight) / 256 for every channel of premultiplied pixels
+    int i = 0;
+#ifdef QGV_WARP_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weight1 = _mm_set1_epi16(static_cast<short>(weight));
+    const __m128i weight0 = _mm_set1_epi16(static_cast<short>(256 - weight));
+    for (; i + 4 <= count; i += 4) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i));
+        const __m128i low = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), weight0),
+                                                         _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), weight1)),
+                                           8);
+        const __m128i high = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), weight0),
+                                                          _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), weight1)),
+                                            8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; ++i) {
+        const quint32 a = row0[i];
+        const quint32 b = row1[i];
+        quint32 result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            const quint32 channel = (((a >> shift) & 0xff) * (256 - weight) + ((b >> shift) & 0xff) * weight) >> 8;
+            result |= channel << shift;
+        }
+        dest[i] = result;
+    }
+}
+}
+
+QGVImageWarp::QGVImageWarp()
+    : mAutoZoom(true)
+    , mMinZoom(0)
+    , mMaxZoom(0)
+{
+    setName("Warp");
+}
+
+void QGVImageWarp::setImage(const QImage& image, const QGV::GeoRect& geoRect)
+{
+    mImage = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    mGeoRect = geoRect;
+    if (mAutoZoom && !mImage.isNull() && geoRect.lonRight() > geoRect.lonLeft()) {
+        // Level where one tile pixel matches one image pixel along longitude
+        const double degreesPerPixel = (geoRect.lonRight() - geoRect.lonLeft()) / mImage.width();
+        const double native = qLn(360.0 / (tileSize * degreesPerPixel)) * M_LOG2E;
+        mMaxZoom = qBound(0, static_cast<int>(qCeil(native)), 22);
+    }
+    reloadTiles();
+}
+
+QImage QGVImageWarp::getImage() const
+{
+    return mImage;
+}
+
+QGV::GeoRect QGVImageWarp::getGeometry() const
+{
+    return mGeoRect;
+}
+
+void QGVImageWarp::setZoomLevels(int minZoom, int maxZoom)
+{
+    mAutoZoom = false;
+    mMinZoom = qMax(0, qMin(minZoom, maxZoom));
+    mMaxZoom = qMax(minZoom, maxZoom);
+}
+
+QImage QGVImageWarp::warpTile(const QImage& image, const QGV::GeoRect& geoRect, const QGV::GeoTilePos& tilePos)
+{
+    Q_ASSERT(image.format() == QImage::Format_ARGB32_Premultiplied);
+    const double lonSpan = geoRect.lonRight() - geoRect.lonLeft();
+    const double latSpan = geoRect.latTop() - geoRect.latBottom();
+    if (image.isNull() || lonSpan <= 0 || latSpan <= 0) {
+        return {};
+    }
+    const int width = image.width();
+    const int height = image.height();
+    const double worldSize = tileSize * static_cast<double>(1 << tilePos.zoom());
+
+    // Longitude is linear in both spaces, nearest source column is enough
+    QVector<int> columns(tileSize);
+    int firstColumn = tileSize;
+    int lastColumn = -1;
+    for (int x = 0; x < tileSize; ++x) {
+        const double lon = (tilePos.pos().x() * tileSize + x + 0.5) / worldSize * 360.0 - 180.0;
+        const int column = qFloor((lon - geoRect.lonLeft()) / lonSpan * width);
+        columns[x] = (column >= 0 && column < width) ? column : -1;
+        if (columns[x] >= 0) {
+            firstColumn = qMin(firstColumn, x);
+            lastColumn = x;
+        }
+    }
+    if (lastColumn < 0) {
+        return {};
+    }
+
+    QImage tile(tileSize, tileSize, QImage::Format_ARGB32_Premultiplied);
+    tile.fill(Qt::transparent);
+    QVector<quint32> row0(tileSize, 0);
+    QVector<quint32> row1(tileSize, 0);
+    bool empty = true;
+    for (int y = 0; y < tileSize; ++y) {
+        // Latitude lookup of tile row, rows between two source rows are blended
+        const double mercator = M_PI * (1.0 - 2.0 * (tilePos.pos().y() * tileSize + y + 0.5) / worldSize);
+        const double lat = qRadiansToDegrees(qAtan(std::sinh(mercator)));
+        const double sourceY = (geoRect.latTop() - lat) / latSpan * height - 0.5;
+        if (sourceY < -0.5 || sourceY > height - 0.5) {
+            continue;
+        }
+        const int y0 = qBound(0, qFloor(sourceY), height - 1);
+        const int y1 = qMin(y0 + 1, height - 1);
+        const int weight = qBound(0, qRound((sourceY - y0) * 256), 256);
+        const quint32* source0 = reinterpret_cast<const quint32*>(image.constScanLine(y0));
+        const quint32* source1 = reinterpret_cast<const quint32*>(image.constScanLine(y1));
+        for (int x = firstColumn; x <= lastColumn; ++x) {
+            const int column = columns.at(x);
+            row0[x] = (column >= 0) ? source0[column] : 0;
+            row1[x] = (column >= 0) ? source1[column] : 0;
+        }
+        quint32* dest = reinterpret_cast<quint32*>(tile.scanLine(y));
+        blendRows(row0.constData() + firstColumn,
+                  row1.constData() + firstColumn,
+                  dest + firstColumn,
+                  lastColumn - firstColumn + 1,
+                  weight);
+        empty = false;
+    }
+    return empty ? QImage() : tile;
+}
+
+int QGVImageWarp::minZoomlevel() const
+{
+    return mMinZoom;
+}
+
+int QGVImageWarp::maxZoomlevel() const
+{
+    return mMaxZoom;
+}
+
+QGVTilesDecoder::Job QGVImageWarp::tileJob(const QGV::GeoTilePos& tilePos) const
+{
+    if (mImage.isNull() || !tilePos.toGeoRect().intersects(mGeoRect)) {
+        return {};
+    }
+    const QImage image = mImage;
+    const QGV::GeoRect geoRect = mGeoRect;
+    return [image, geoRect, tilePos]() { return warpTile(image, geoRect, tilePos); };
+}
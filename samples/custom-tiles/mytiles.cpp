@@ -47,6 +47,7 @@ void MyTiles::request(const QGV::GeoTilePos& tilePos)
 {
     auto tilePosParent = tilePos.parent(minZoomlevel()).pos();
     if (!mActiveTileRect.contains(tilePosParent)) {
+        onTileFailed(tilePos);
         return;
     }
     QGVDrawItem* tile = new MyTile(tilePos, mColor);
@@ -18,8 +18,14 @@
 
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QDebug>
+#include <QTimer>
 
 #include "mainwindow.h"
+#include "tilesbenchmark.h"
+#include "viewportbenchmark.h"
+
+#include <mocknetwork.h>
 
 int main(int argc, char* argv[])
 {
@@ -29,9 +35,61 @@ int main(int argc, char* argv[])
     QCommandLineParser parser;
     parser.addHelpOption();
     parser.addVersionOption();
+    QCommandLineOption benchmarkIndex("benchmark-index", "Run benchmark for tiles index and exit.");
+    QCommandLineOption benchmarkViewport("benchmark-viewport",
+                                         "Measure time to full viewport for demo areas and exit (network is mocked "
+                                         "unless --record is set).");
+    QCommandLineOption mock("mock", "Serve generated tiles instead of network.");
+    QCommandLineOption record("record", "Pass requests to network and save tiles to <dir>.", "dir");
+    QCommandLineOption replay("replay", "Serve tiles recorded in <dir>.", "dir");
+    QCommandLineOption latency("mock-latency", "Latency of mocked network in ms.", "ms", "50");
+    QCommandLineOption jitter("mock-jitter", "Jitter of mocked network in ms.", "ms", "0");
+    QCommandLineOption bandwidth("mock-bandwidth", "Bandwidth of mocked network in KB/s (0 - unlimited).", "kbps", "0");
+    QCommandLineOption errors("mock-errors", "Part of mocked requests failed with 503.", "rate", "0");
+    QCommandLineOption missing("mock-missing", "Part of mocked requests failed with 404.", "rate", "0");
+    parser.addOptions({ benchmarkIndex, benchmarkViewport, mock, record, replay, latency, jitter, bandwidth, errors,
+                        missing });
     parser.process(app);
 
+    if (parser.isSet(benchmarkIndex)) {
+        qInfo().noquote() << TilesBenchmark::runIndex();
+        return 0;
+    }
+
+    MockNetworkAccessManager* network = nullptr;
+    if (parser.isSet(record)) {
+        network = new MockNetworkAccessManager(MockNetworkAccessManager::Mode::Record, parser.value(record), &app);
+    } else if (parser.isSet(replay)) {
+        network = new MockNetworkAccessManager(MockNetworkAccessManager::Mode::Replay, parser.value(replay), &app);
+    } else if (parser.isSet(mock) || parser.isSet(benchmarkViewport)) {
+        network = new MockNetworkAccessManager(MockNetworkAccessManager::Mode::Generate, {}, &app);
+    }
+    if (network != nullptr) {
+        MockNetworkAccessManager::Profile profile;
+        profile.latencyMs = parser.value(latency).toInt();
+        profile.jitterMs = parser.value(jitter).toInt();
+        profile.bytesPerSecond = parser.value(bandwidth).toLongLong() * 1024;
+        profile.errorRate = parser.value(errors).toDouble();
+        profile.notFoundRate = parser.value(missing).toDouble();
+        network->setProfile(profile);
+    }
+
     MainWindow window;
+    if (network != nullptr) {
+        // Tiles store is disabled, otherwise repeated runs are served from disk
+        QGV::setNetworkManager(network);
+        QGV::setTilesStore(nullptr);
+    }
     window.show();
+
+    if (parser.isSet(benchmarkViewport)) {
+        QGV::setPrintDebug(false);
+        auto benchmark = new ViewportBenchmark(window.getMap(), window.demoAreas(), network, &app);
+        QObject::connect(benchmark, &ViewportBenchmark::finished, &app, [&app](const QString& report) {
+            qInfo().noquote() << report;
+            app.quit();
+        });
+        QTimer::singleShot(0, benchmark, &ViewportBenchmark::start);
+    }
     return app.exec();
 }
@@ -65,6 +65,20 @@ MainWindow::~MainWindow()
 {
 }
 
+QGVMap* MainWindow::getMap() const
+{
+    return mMap;
+}
+
+QList<QGV::GeoRect> MainWindow::demoAreas() const
+{
+    return {
+        QGV::GeoRect(QGV::GeoPos(56.316425, 80.670445), QGV::GeoPos(53.280950, 86.641856)),
+        QGV::GeoRect(QGV::GeoPos(52.131852, 4.989964), QGV::GeoPos(44.071465, 18.708665)),
+        QGV::GeoRect(QGV::GeoPos(-17.631899, 20.654501), QGV::GeoPos(-29.494330, 35.357840)),
+    };
+}
+
 QGV::GeoRect MainWindow::target10000Area() const
 {
     return mMap->getProjection()->boundaryGeoRect();
@@ -205,13 +219,9 @@ QGroupBox* MainWindow::createOptionsList()
 void MainWindow::flyToRandomArea()
 {
     static int current = 0;
-    static const std::vector<QGV::GeoRect> areas = {
-        QGV::GeoRect(QGV::GeoPos(56.316425, 80.670445), QGV::GeoPos(53.280950, 86.641856)),
-        QGV::GeoRect(QGV::GeoPos(52.131852, 4.989964), QGV::GeoPos(44.071465, 18.708665)),
-        QGV::GeoRect(QGV::GeoPos(-17.631899, 20.654501), QGV::GeoPos(-29.494330, 35.357840)),
-    };
+    const QList<QGV::GeoRect> areas = demoAreas();
 
-    QTimer::singleShot(100, this, [&]() {
+    QTimer::singleShot(100, this, [this, areas]() {
         mMap->flyTo(QGVCameraActions(mMap).scaleTo(areas[current % areas.size()]));
         current++;
     });
@@ -33,6 +33,9 @@ public:
     MainWindow();
     ~MainWindow();
 
+    QGVMap* getMap() const;
+    QList<QGV::GeoRect> demoAreas() const;
+
     QGV::GeoRect target10000Area() const;
     QGVLayer* create10000Layer() const;
 
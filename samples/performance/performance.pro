@@ -9,7 +9,11 @@ include(../shared.pri)
 
 SOURCES += \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    tilesbenchmark.cpp \
+    viewportbenchmark.cpp
 
 HEADERS += \
-    mainwindow.h
+    mainwindow.h \
+    tilesbenchmark.h \
+    viewportbenchmark.h
@@ -0,0 +1,134 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "tilesbenchmark.h"
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QRect>
+
+#include <QGeoView/QGVTilesPyramid.h>
+
+namespace {
+/*
+ * Copy of tiles index used by QGVLayerTiles before QGVTilesPyramid, kept only for comparison.
+ */
+using LegacyIndex = QMap<int, QMap<QGV::GeoTilePos, QGVDrawItem*>>;
+
+QList<QGV::GeoTilePos> legacyExistingTiles(const LegacyIndex& index, int zoom)
+{
+    return index[zoom].keys();
+}
+
+int legacyTileArrival(const LegacyIndex& index, const QGV::GeoTilePos& tilePos, int minZoom, int maxZoom)
+{
+    int hits = 0;
+    for (int zoom = tilePos.zoom() + 1; zoom <= maxZoom; ++zoom) {
+        for (const QGV::GeoTilePos& target : legacyExistingTiles(index, zoom)) {
+            if (tilePos.contains(target)) {
+                hits++;
+            }
+        }
+    }
+    for (int zoom = minZoom; zoom < tilePos.zoom(); ++zoom) {
+        for (const QGV::GeoTilePos& below : legacyExistingTiles(index, zoom)) {
+            if (below.contains(tilePos)) {
+                hits++;
+            }
+        }
+    }
+    return hits;
+}
+
+int pyramidTileArrival(const QGVTilesPyramid& index, const QGV::GeoTilePos& tilePos, int minZoom, int maxZoom)
+{
+    int hits = 0;
+    QVector<QGV::GeoTilePos> above;
+    for (int zoom = tilePos.zoom() + 1; zoom <= maxZoom; ++zoom) {
+        above.clear();
+        index.findDescendants(tilePos, zoom, above);
+        hits += above.size();
+    }
+    for (int zoom = minZoom; zoom < tilePos.zoom(); ++zoom) {
+        if (index.contains(tilePos.parent(zoom))) {
+            hits++;
+        }
+    }
+    return hits;
+}
+}
+
+/*
+ * Emulates arrival of every tile in viewport of 4K display at zoom 18 (with margin), when map also keeps
+ * tiles of 6 lower zoom levels. For each arrival QGVLayerTiles looks for tiles above (to remove them) and for tiles
+ * below (to check coverage).
+ */
+QString TilesBenchmark::runIndex(int iterations)
+{
+    const int minZoom = 0;
+    const int maxZoom = 20;
+    const int curZoom = 18;
+    const int keptZooms = 6;
+    const QRect area(QPoint(140000, 85000), QSize(24, 16));
+
+    LegacyIndex legacy;
+    QGVTilesPyramid pyramid;
+    for (int zoom = curZoom - keptZooms; zoom <= curZoom; ++zoom) {
+        const int shift = curZoom - zoom;
+        for (int x = area.left() >> shift; x <= (area.right() >> shift); ++x) {
+            for (int y = area.top() >> shift; y <= (area.bottom() >> shift); ++y) {
+                const QGV::GeoTilePos tilePos(zoom, QPoint(x, y));
+                legacy[zoom][tilePos] = nullptr;
+                pyramid.insert(tilePos, nullptr);
+            }
+        }
+    }
+    const QList<QGV::GeoTilePos> arrivals = legacy[curZoom].keys();
+
+    QElapsedTimer timer;
+    int legacyHits = 0;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        for (const QGV::GeoTilePos& tilePos : arrivals) {
+            legacyHits += legacyTileArrival(legacy, tilePos, minZoom, maxZoom);
+        }
+    }
+    const qint64 legacyNs = timer.nsecsElapsed();
+
+    int pyramidHits = 0;
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        for (const QGV::GeoTilePos& tilePos : arrivals) {
+            pyramidHits += pyramidTileArrival(pyramid, tilePos, minZoom, maxZoom);
+        }
+    }
+    const qint64 pyramidNs = timer.nsecsElapsed();
+
+    return QString("Tiles index benchmark (%1 tiles in index, %2 arrivals x %3)\n"
+                   "  nested QMap:     %4 ms (%5 hits)\n"
+                   "  QGVTilesPyramid: %6 ms (%7 hits)\n"
+                   "  speedup:         x%8")
+            .arg(pyramid.count())
+            .arg(arrivals.size())
+            .arg(iterations)
+            .arg(legacyNs / 1e6, 0, 'f', 2)
+            .arg(legacyHits)
+            .arg(pyramidNs / 1e6, 0, 'f', 2)
+            .arg(pyramidHits)
+            .arg(static_cast<double>(legacyNs) / qMax(Q_INT64_C(1), pyramidNs), 0, 'f', 1);
+}
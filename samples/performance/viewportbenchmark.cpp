@@ -0,0 +1,110 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "viewportbenchmark.h"
+
+#include <mocknetwork.h>
+
+#include <QGeoView/QGVTilesFetcher.h>
+
+namespace {
+const int pollIntervalMs = 10;
+const int settleMs = 300;
+const int stepTimeoutMs = 60000;
+}
+
+ViewportBenchmark::ViewportBenchmark(QGVMap* geoMap,
+                                     const QList<QGV::GeoRect>& areas,
+                                     MockNetworkAccessManager* network,
+                                     QObject* parent)
+    : QObject(parent)
+    , mGeoMap(geoMap)
+    , mAreas(areas)
+    , mNetwork(network)
+    , mLastBusy(0)
+    , mCurrent(-1)
+{
+    mPoll.setInterval(pollIntervalMs);
+    connect(&mPoll, &QTimer::timeout, this, &ViewportBenchmark::poll);
+}
+
+void ViewportBenchmark::start()
+{
+    QGVTilesFetcher::globalFetcher()->resetStatistics();
+    if (mNetwork != nullptr) {
+        mNetwork->resetCounters();
+    }
+    mLines.clear();
+    mLines.append("Time to full viewport:");
+    mTotal.start();
+    mCurrent = -1;
+    nextStep();
+}
+
+void ViewportBenchmark::nextStep()
+{
+    mCurrent++;
+    if (mCurrent >= mAreas.size()) {
+        mPoll.stop();
+        const QGVTilesFetcher::Statistics stat = QGVTilesFetcher::globalFetcher()->statistics();
+        mLines.append(QString("  total: %1 ms").arg(mTotal.elapsed()));
+        mLines.append(QString("Fetcher: %1 requests, %2 coalesced, %3 network, %4 store, %5 failed, %6 retries")
+                              .arg(stat.requests)
+                              .arg(stat.coalesced)
+                              .arg(stat.fromNetwork)
+                              .arg(stat.fromStore)
+                              .arg(stat.failed)
+                              .arg(stat.retries));
+        if (mNetwork != nullptr) {
+            mLines.append(QString("Network: %1 requests, %2 failed, %3 KB")
+                                  .arg(mNetwork->requestsCount())
+                                  .arg(mNetwork->failedCount())
+                                  .arg(mNetwork->bytesCount() / 1024));
+        }
+        Q_EMIT finished(mLines.join('\n'));
+        return;
+    }
+    mGeoMap->cameraTo(QGVCameraActions(mGeoMap).scaleTo(mAreas.at(mCurrent)));
+    mStep.start();
+    mLastBusy = 0;
+    mPoll.start();
+}
+
+void ViewportBenchmark::poll()
+{
+    const qint64 elapsed = mStep.elapsed();
+    if (isBusy()) {
+        mLastBusy = elapsed;
+    }
+    const bool settled = elapsed - mLastBusy >= settleMs;
+    const bool timeout = elapsed >= stepTimeoutMs;
+    if (!settled && !timeout) {
+        return;
+    }
+    mPoll.stop();
+    mLines.append(QString("  area %1: %2 ms%3").arg(mCurrent).arg(mLastBusy).arg(timeout ? " (timeout)" : ""));
+    nextStep();
+}
+
+bool ViewportBenchmark::isBusy() const
+{
+    if (QGVTilesFetcher::globalFetcher()->activeCount() > 0) {
+        return true;
+    }
+    return mNetwork != nullptr && mNetwork->pendingCount() > 0;
+}
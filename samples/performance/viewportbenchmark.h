@@ -0,0 +1,64 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <QGeoView/QGVMap.h>
+
+class MockNetworkAccessManager;
+
+/*
+ * Moves camera through list of areas and measures time until viewport is fully loaded, i.e. tiles fetcher and
+ * network have no pending requests for settle period. Request counts are taken from fetcher statistics and
+ * mock network (when used).
+ */
+class ViewportBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    ViewportBenchmark(QGVMap* geoMap,
+                      const QList<QGV::GeoRect>& areas,
+                      MockNetworkAccessManager* network,
+                      QObject* parent = nullptr);
+
+    void start();
+
+Q_SIGNALS:
+    void finished(const QString& report);
+
+private:
+    void nextStep();
+    void poll();
+    bool isBusy() const;
+
+private:
+    QGVMap* mGeoMap;
+    QList<QGV::GeoRect> mAreas;
+    MockNetworkAccessManager* mNetwork;
+    QTimer mPoll;
+    QElapsedTimer mStep;
+    QElapsedTimer mTotal;
+    qint64 mLastBusy;
+    int mCurrent;
+    QStringList mLines;
+};
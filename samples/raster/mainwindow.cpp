@@ -19,6 +19,7 @@
 #include "mainwindow.h"
 
 #include <QCheckBox>
+#include <QFileDialog>
 #include <QHBoxLayout>
 #include <QListWidget>
 #include <QPushButton>
@@ -33,7 +34,9 @@
 #include <QGeoView/QGVWidgetScale.h>
 #include <QGeoView/QGVWidgetZoom.h>
 #include <QGeoView/Raster/QGVIcon.h>
+#include <QGeoView/Raster/QGVIconBatch.h>
 #include <QGeoView/Raster/QGVImage.h>
+#include <QGeoView/Raster/QGVImageTiles.h>
 
 MainWindow::MainWindow()
 {
@@ -95,6 +98,13 @@ QGroupBox* MainWindow::createOptionsList()
         connect(button, &QPushButton::clicked, this, &MainWindow::addImage);
     }
 
+    {
+        QPushButton* button = new QPushButton("Add large image file");
+        groupBox->layout()->addWidget(button);
+
+        connect(button, &QPushButton::clicked, this, &MainWindow::addImageFile);
+    }
+
     {
         QPushButton* button = new QPushButton("Add icon");
         groupBox->layout()->addWidget(button);
@@ -102,6 +112,13 @@ QGroupBox* MainWindow::createOptionsList()
         connect(button, &QPushButton::clicked, this, &MainWindow::addIcon);
     }
 
+    {
+        QPushButton* button = new QPushButton("Add 10000 icons batch");
+        groupBox->layout()->addWidget(button);
+
+        connect(button, &QPushButton::clicked, this, &MainWindow::addIconBatch);
+    }
+
     {
         QPushButton* button = new QPushButton("Remove last");
         groupBox->layout()->addWidget(button);
@@ -169,6 +186,24 @@ void MainWindow::addImage()
     updateListOfItems();
 }
 
+void MainWindow::addImageFile()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Open image"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    auto* item = new QGVImageTiles(fileName, targetArea());
+    if (!item->isValid()) {
+        delete item;
+        return;
+    }
+
+    mLayer->addItem(item);
+
+    updateListOfItems();
+}
+
 void MainWindow::addIcon()
 {
     const QGV::GeoRect itemTargetArea = mMap->getProjection()->projToGeo(mMap->getCamera().projRect());
@@ -182,6 +217,23 @@ void MainWindow::addIcon()
     updateListOfItems();
 }
 
+void MainWindow::addIconBatch()
+{
+    const QGV::GeoRect itemTargetArea = mMap->getProjection()->projToGeo(mMap->getCamera().projRect());
+
+    auto* item = new QGVIconBatch();
+    const int sprite = item->addSprite(mIcon, QSizeF(16, 16));
+    QVector<QGV::GeoPos> positions(10000);
+    for (QGV::GeoPos& pos : positions) {
+        pos = Helpers::randPos(itemTargetArea);
+    }
+    item->setIcons(positions, QVector<int>(positions.size(), sprite));
+
+    mLayer->addItem(item);
+
+    updateListOfItems();
+}
+
 void MainWindow::removeLast()
 {
     if (mLayer->countItems() == 0) {
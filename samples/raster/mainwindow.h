@@ -42,7 +42,9 @@ public:
     void loadImage(QImage& dest, QUrl url);
 
     void addImage();
+    void addImageFile();
     void addIcon();
+    void addIconBatch();
     void removeLast();
     void updateListOfItems();
 
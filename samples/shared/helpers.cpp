@@ -18,9 +18,10 @@
 
 #include "helpers.h"
 
-#include <QDir>
+#include <QGeoView/QGVTilesDecoder.h>
+#include <QGeoView/QGVTilesStore.h>
+
 #include <QNetworkAccessManager>
-#include <QNetworkDiskCache>
 #include <QRandomGenerator>
 
 int Helpers::randomInt(int lowest, int highest)
@@ -67,10 +68,13 @@ QSizeF Helpers::randSize(int baseSize)
 
 void Helpers::setupCachedNetworkAccessManager(QObject* parent)
 {
-    QDir("cacheDir").removeRecursively();
-    auto cache = new QNetworkDiskCache(parent);
-    cache->setCacheDirectory("cacheDir");
     auto manager = new QNetworkAccessManager(parent);
-    manager->setCache(cache);
     QGV::setNetworkManager(manager);
+    auto store = new QGVTilesStore("tilesStore");
+    QGV::setTilesStore(store);
+    QObject::connect(parent, &QObject::destroyed, [store]() {
+        QGV::setTilesStore(nullptr);
+        QGVTilesDecoder::globalDecoder()->waitForDone();
+        delete store;
+    });
 }
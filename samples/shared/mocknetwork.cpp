@@ -0,0 +1,317 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "mocknetwork.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QNetworkReply>
+#include <QPainter>
+#include <QPointer>
+#include <QTimer>
+
+#include <cstring>
+
+namespace {
+const int tileSize = 256;
+const int generatedCacheLimit = 4096;
+
+class MockReply : public QNetworkReply
+{
+public:
+    MockReply(const QNetworkRequest& request, int status, const QByteArray& data, QObject* parent)
+        : QNetworkReply(parent)
+        , mStatus(status)
+        , mData(data)
+        , mOffset(0)
+    {
+        setRequest(request);
+        setUrl(request.url());
+        setOperation(QNetworkAccessManager::GetOperation);
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    void complete()
+    {
+        if (isFinished()) {
+            return;
+        }
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, mStatus);
+        if (mStatus == 404) {
+            mData.clear();
+            setError(QNetworkReply::ContentNotFoundError, "Not found");
+        } else if (mStatus >= 500) {
+            mData.clear();
+            setError(QNetworkReply::ServiceUnavailableError, "Service unavailable");
+        } else if (mStatus == 200) {
+            setRawHeader("ETag", etag(mData));
+        } else {
+            mData.clear();
+        }
+        setHeader(QNetworkRequest::ContentLengthHeader, mData.size());
+        Q_EMIT metaDataChanged();
+        if (!mData.isEmpty()) {
+            Q_EMIT readyRead();
+        }
+        setFinished(true);
+        Q_EMIT finished();
+    }
+
+    void abort() override
+    {
+        if (isFinished()) {
+            return;
+        }
+        mData.clear();
+        setError(QNetworkReply::OperationCanceledError, "Operation canceled");
+        setFinished(true);
+        Q_EMIT finished();
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        return mData.size() - mOffset + QNetworkReply::bytesAvailable();
+    }
+
+    bool isSequential() const override
+    {
+        return true;
+    }
+
+    static QByteArray etag(const QByteArray& data)
+    {
+        return '"' + QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() + '"';
+    }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
+    {
+        const qint64 size = qMin(maxSize, mData.size() - mOffset);
+        if (size <= 0) {
+            return isFinished() ? -1 : 0;
+        }
+        std::memcpy(data, mData.constData() + mOffset, static_cast<size_t>(size));
+        mOffset += size;
+        return size;
+    }
+
+private:
+    int mStatus;
+    QByteArray mData;
+    qint64 mOffset;
+};
+}
+
+MockNetworkAccessManager::MockNetworkAccessManager(Mode mode, const QString& directory, QObject* parent)
+    : QNetworkAccessManager(parent)
+    , mMode(mode)
+    , mDirectory(directory)
+    , mRandom(mProfile.seed)
+    , mLinkFreeAt(0)
+    , mRequests(0)
+    , mFailed(0)
+    , mPending(0)
+    , mBytes(0)
+{
+    mClock.start();
+    if (!mDirectory.isEmpty()) {
+        QDir().mkpath(mDirectory);
+    }
+}
+
+MockNetworkAccessManager::Mode MockNetworkAccessManager::getMode() const
+{
+    return mMode;
+}
+
+void MockNetworkAccessManager::setProfile(const Profile& profile)
+{
+    mProfile = profile;
+    mRandom.seed(profile.seed);
+}
+
+MockNetworkAccessManager::Profile MockNetworkAccessManager::getProfile() const
+{
+    return mProfile;
+}
+
+int MockNetworkAccessManager::requestsCount() const
+{
+    return mRequests;
+}
+
+int MockNetworkAccessManager::failedCount() const
+{
+    return mFailed;
+}
+
+int MockNetworkAccessManager::pendingCount() const
+{
+    return mPending;
+}
+
+qint64 MockNetworkAccessManager::bytesCount() const
+{
+    return mBytes;
+}
+
+void MockNetworkAccessManager::resetCounters()
+{
+    mRequests = 0;
+    mFailed = 0;
+    mBytes = 0;
+}
+
+QNetworkReply* MockNetworkAccessManager::createRequest(Operation op,
+                                                       const QNetworkRequest& request,
+                                                       QIODevice* outgoingData)
+{
+    if (op != GetOperation) {
+        return QNetworkAccessManager::createRequest(op, request, outgoingData);
+    }
+    mRequests++;
+    mPending++;
+    if (mMode == Mode::Record) {
+        QNetworkReply* reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
+        // Connected before any user of reply, so data can be peeked before it is read
+        connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+            record(reply);
+            const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            onReplyFinished(reply, status, reply->bytesAvailable());
+        });
+        return reply;
+    }
+    return createMockReply(request);
+}
+
+QNetworkReply* MockNetworkAccessManager::createMockReply(const QNetworkRequest& request)
+{
+    const QUrl url = request.url();
+    QByteArray data;
+    int status = 200;
+    const double failure = mRandom.generateDouble();
+    if (failure < mProfile.errorRate) {
+        status = 503;
+    } else if (failure < mProfile.errorRate + mProfile.notFoundRate) {
+        status = 404;
+    } else if (mMode == Mode::Replay) {
+        QFile file(recordPath(url));
+        if (file.open(QIODevice::ReadOnly)) {
+            data = file.readAll();
+        } else {
+            status = 404;
+        }
+    } else {
+        data = generateTile(url);
+    }
+    if (status == 200 && request.rawHeader("If-None-Match") == MockReply::etag(data)) {
+        status = 304;
+        data.clear();
+    }
+
+    const qint64 now = mClock.elapsed();
+    const int jitter = (mProfile.jitterMs > 0) ? static_cast<int>(mRandom.bounded(mProfile.jitterMs + 1)) : 0;
+    qint64 doneAt = now + mProfile.latencyMs + jitter;
+    if (mProfile.bytesPerSecond > 0) {
+        // All replies share one link, transfer starts when link becomes free
+        const qint64 transferMs = data.size() * 1000 / mProfile.bytesPerSecond;
+        doneAt = qMax(doneAt, mLinkFreeAt) + transferMs;
+        mLinkFreeAt = doneAt;
+    }
+
+    auto reply = new MockReply(request, status, data, this);
+    const qint64 bytes = data.size();
+    QPointer<MockReply> guard(reply);
+    QTimer::singleShot(static_cast<int>(doneAt - now), this, [this, guard, status, bytes]() {
+        if (guard.isNull()) {
+            mPending--;
+            return;
+        }
+        const bool aborted = guard->isFinished();
+        guard->complete();
+        onReplyFinished(guard, aborted ? 0 : status, aborted ? 0 : bytes);
+    });
+    return reply;
+}
+
+QByteArray MockNetworkAccessManager::generateTile(const QUrl& url)
+{
+    const QString key = url.toString();
+    auto it = mGenerated.constFind(key);
+    if (it != mGenerated.constEnd()) {
+        return it.value();
+    }
+    const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5);
+    const QColor color(160 + static_cast<quint8>(hash[0]) % 96,
+                       160 + static_cast<quint8>(hash[1]) % 96,
+                       160 + static_cast<quint8>(hash[2]) % 96);
+
+    QImage image(tileSize, tileSize, QImage::Format_RGB32);
+    image.fill(color);
+    QPainter painter(&image);
+    painter.setPen(Qt::darkGray);
+    painter.drawRect(0, 0, tileSize - 1, tileSize - 1);
+    painter.drawText(image.rect().adjusted(8, 8, -8, -8), Qt::AlignCenter | Qt::TextWrapAnywhere, url.path());
+    painter.end();
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+
+    if (mGenerated.size() >= generatedCacheLimit) {
+        mGenerated.clear();
+    }
+    mGenerated.insert(key, data);
+    return data;
+}
+
+QString MockNetworkAccessManager::recordPath(const QUrl& url) const
+{
+    // Mirrors serve the same tiles and are chosen by host weights, so record is keyed by path and query only
+    const QByteArray path = url.adjusted(QUrl::RemoveScheme | QUrl::RemoveAuthority).toEncoded();
+    const QByteArray name = QCryptographicHash::hash(path, QCryptographicHash::Sha1).toHex();
+    return mDirectory + "/" + QString::fromLatin1(name) + ".tile";
+}
+
+void MockNetworkAccessManager::record(QNetworkReply* reply)
+{
+    if (mDirectory.isEmpty() || reply->error() != QNetworkReply::NoError) {
+        return;
+    }
+    const QByteArray data = reply->peek(reply->bytesAvailable());
+    if (data.isEmpty()) {
+        return;
+    }
+    QFile file(recordPath(reply->request().url()));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(data);
+    }
+}
+
+void MockNetworkAccessManager::onReplyFinished(QNetworkReply* reply, int status, qint64 bytes)
+{
+    mPending--;
+    if (reply->error() != QNetworkReply::NoError && status != 0) {
+        mFailed++;
+    }
+    mBytes += bytes;
+}
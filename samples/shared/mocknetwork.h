@@ -0,0 +1,93 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QRandomGenerator>
+
+/*
+ * Network manager for offline and reproducible runs of samples and benchmarks.
+ * Generate: every request is answered by generated tile (url is printed on it).
+ * Record: requests go to real network, successful replies are saved in directory.
+ * Replay: requests are answered from directory, missing ones with 404.
+ * In Generate and Replay modes replies are delayed by latency, jitter and shared link bandwidth, part of them
+ * can fail with 503 or 404 errors.
+ */
+class MockNetworkAccessManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    enum class Mode
+    {
+        Generate,
+        Record,
+        Replay,
+    };
+    struct Profile
+    {
+        int latencyMs = 50;
+        int jitterMs = 0;
+        qint64 bytesPerSecond = 0;
+        double errorRate = 0.0;
+        double notFoundRate = 0.0;
+        quint32 seed = 1;
+    };
+
+    explicit MockNetworkAccessManager(Mode mode = Mode::Generate,
+                                      const QString& directory = {},
+                                      QObject* parent = nullptr);
+
+    Mode getMode() const;
+    void setProfile(const Profile& profile);
+    Profile getProfile() const;
+
+    int requestsCount() const;
+    int failedCount() const;
+    int pendingCount() const;
+    qint64 bytesCount() const;
+    void resetCounters();
+
+protected:
+    QNetworkReply* createRequest(Operation op,
+                                 const QNetworkRequest& request,
+                                 QIODevice* outgoingData = nullptr) override;
+
+private:
+    QNetworkReply* createMockReply(const QNetworkRequest& request);
+    QByteArray generateTile(const QUrl& url);
+    QString recordPath(const QUrl& url) const;
+    void record(QNetworkReply* reply);
+    void onReplyFinished(QNetworkReply* reply, int status, qint64 bytes);
+
+private:
+    Mode mMode;
+    QString mDirectory;
+    Profile mProfile;
+    QRandomGenerator mRandom;
+    QElapsedTimer mClock;
+    qint64 mLinkFreeAt;
+    QHash<QString, QByteArray> mGenerated;
+    int mRequests;
+    int mFailed;
+    int mPending;
+    qint64 mBytes;
+};
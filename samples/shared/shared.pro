@@ -8,10 +8,12 @@ include(../lib.pri)
 
 SOURCES += \
     $$PWD/helpers.cpp \
+    $$PWD/mocknetwork.cpp \
     $$PWD/placemarkcircle.cpp \
     $$PWD/rectangle.cpp
 
 HEADERS += \
     $$PWD/helpers.h \
+    $$PWD/mocknetwork.h \
     $$PWD/placemarkcircle.h \
     $$PWD/rectangle.h